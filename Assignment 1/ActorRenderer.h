@@ -0,0 +1,86 @@
+#pragma once
+#include "GamesEngineeringBase.h"
+#include "Camera.h"
+#include "Hero.h"
+#include "Manager.h"
+#include "SpriteSheet.h"
+#include "RenderQueue.h"
+#include "ProjectileRenderer.h"
+#include "Raster.h"
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+// The ActorRenderer draws the hero, the enemies, the projectiles and the AOE ring. It owns every sprite of them, the
+// hero and the manager only keep plain numbers, so the simulation (and the headless SimRunner) doesn't need the window
+// or the images at all.
+class ActorRenderer {
+    SpriteSheet heroIdle; // we have a idle image which displays when hero is standing still
+    SpriteSheet heroWalk; // we also have a walking image which gets activated when our hero moves
+    vector<SpriteSheet> enemySheets; // the idle sheet of every enemy type, by type index
+    ProjectileRenderer projectileBatch; // draws all the visible projectiles of a frame together
+    vector<int> visibleEnemies; // reused by draw() so culling doesn't allocate
+
+public:
+    // takes the images from the asset loader, the enemy sprites are the ones named in the types of the manager
+    ActorRenderer(const Manager& manager, const string& heroIdleFile, const string& heroWalkFile) {
+        heroIdle.load(heroIdleFile);
+        heroWalk.load(heroWalkFile);
+        const vector<EnemyType>& types = manager.getEnemyTypes();
+        enemySheets.resize(types.size());
+        for (unsigned int t = 0; t < types.size(); t++) {
+            enemySheets[t].load(types[t].idleSprite);
+        }
+        projectileBatch.reserve(manager.getProjectiles().getCapacity());
+    }
+
+    // queues the hero and the enemies that are in the view, they are drawn when the queue is executed
+    void draw(RenderQueue& sprites, GamesEngineeringBase::Window& canvas, Camera& camera, const Hero& hero, const Manager& manager) {
+        // the queue sorts the hero between the enemies by y, the blitter then clips the frame against the screen
+        const SpriteSheet& heroSheet = hero.isWalking() ? heroWalk : heroIdle;
+        heroSheet.draw(sprites, camera, hero.getFrame(), 32, 32, hero.getX(), hero.getY());
+
+        float camX = camera.getX();
+        float camY = camera.getY();
+        float viewW = (float)canvas.getWidth();
+        float viewH = (float)canvas.getHeight();
+
+        // we only ask the grid for the enemies in the view instead of checking all of them. an enemy is drawn from its
+        // top left corner so one that is up to a sprite size left of or above the view is still partly visible
+        visibleEnemies.clear();
+        manager.getEnemyGrid().queryRect(camX - 32, camY - 32, camX + viewW, camY + viewH, visibleEnemies);
+        sort(visibleEnemies.begin(), visibleEnemies.end()); // the grid gives them in cell order, sorted they walk the columns forwards
+        const EnemyArchetype& enemies = manager.getEnemies();
+        for (unsigned int v = 0; v < visibleEnemies.size(); v++) {
+            unsigned int i = visibleEnemies[v];
+            enemySheets[enemies.type[i]].draw(sprites, camera, enemies.frame[i], 32, 32, enemies.x[i], enemies.y[i]);
+        }
+    }
+
+    // draws the projectiles on top of the sprites
+    void drawProjectiles(GamesEngineeringBase::Window& canvas, Camera& camera, const Manager& manager) {
+        projectileBatch.begin(canvas.getWidth(), canvas.getHeight());
+        projectileBatch.addAll(manager.getProjectiles(), camera.getX(), camera.getY());
+        projectileBatch.draw(canvas);
+    }
+
+    void drawAOE(GamesEngineeringBase::Window& canvas, Camera& camera, float cx, float cy, float range) {// cx and cy are the center coordinates of the AOE
+        // range is the radius of the AOE circle
+
+        float camX = camera.getX();  // get current camera position for x and y
+        float camY = camera.getY();
+
+        int centerX = (int)(cx - camX);  // applying camera offset
+        int centerY = (int)(cy - camY);  // same for y
+
+        int r2outer = (int)(range * range);  // square of the AOE radius
+
+        float innerRange = range - 10.0f;      // we create a slightly smaller inner circle
+        int r2inner = (int)(innerRange * innerRange);  // its squared radius
+        // the goal is to draw only the ring area not a filled disc
+
+        // We draw only the pixels that fall inside the outer circle but outside the inner circle.
+        // the raster works out the two ends of the ring on every row so we don't test the whole square anymore
+        Raster::fillRing(canvas, centerX, centerY, r2outer, r2inner, 0, 0, 255); // blue pixels to represent AoE circle
+    }
+};
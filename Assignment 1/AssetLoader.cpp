@@ -0,0 +1,113 @@
+#include "AssetLoader.h"
+
+AssetLoader assetLoader;
+
+void AssetLoader::startWorkers() {
+    // images are small so a few threads are enough, we leave one core for the main thread and the console menu
+    unsigned int count = thread::hardware_concurrency();
+    count = (count > 1) ? count - 1 : 1;
+    if (count > 4) {
+        count = 4;
+    }
+    for (unsigned int i = 0; i < count; i++) {
+        workers.emplace_back(&AssetLoader::workerLoop, this);
+    }
+}
+
+void AssetLoader::workerLoop() {
+    // WIC is a COM library so every thread that decodes images needs its own COM initialization
+    CoInitializeEx(NULL, COINIT_MULTITHREADED);
+    while (true) {
+        Asset* asset = nullptr;
+        {
+            unique_lock<mutex> guard(lock);
+            workAvailable.wait(guard, [this] { return stopping || !pending.empty(); });
+            if (stopping) {
+                break;
+            }
+            asset = assets[pending.front()];
+            pending.pop_front();
+        }
+
+        // decoding happens outside the lock so the workers really run in parallel
+        if (!asset->image.load(asset->filename) || asset->image.width == 0) {
+            cout << "Warning: could not load " << asset->filename << endl;
+        }
+
+        {
+            lock_guard<mutex> guard(lock);
+            asset->ready = true;
+        }
+        assetReady.notify_all();
+    }
+    CoUninitialize();
+}
+
+AssetLoader::~AssetLoader() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (unsigned int i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    for (unsigned int i = 0; i < assets.size(); i++) {
+        delete assets[i];
+    }
+}
+
+int AssetLoader::request(const string& filename) {
+    lock_guard<mutex> guard(lock);
+    auto it = handles.find(filename);
+    if (it != handles.end()) {
+        return it->second; // it is already decoded or on its way
+    }
+    if (workers.empty()) {
+        startWorkers(); // threads are only created when the first image is requested
+    }
+    Asset* asset = new Asset();
+    asset->filename = filename;
+    int handle = (int)assets.size();
+    assets.push_back(asset);
+    handles[filename] = handle;
+    pending.push_back(handle);
+    workAvailable.notify_one();
+    return handle;
+}
+
+GamesEngineeringBase::Image& AssetLoader::get(int handle) {
+    unique_lock<mutex> guard(lock);
+    Asset* asset = assets[handle];
+    assetReady.wait(guard, [asset] { return asset->ready; });
+    return asset->image;
+}
+
+bool AssetLoader::allReady() {
+    lock_guard<mutex> guard(lock);
+    if (!pending.empty()) {
+        return false;
+    }
+    for (unsigned int i = 0; i < assets.size(); i++) {
+        if (!assets[i]->ready) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AssetLoader::preloadGameAssets() {
+    // the tiles are named 0.png, 1.png, ... 23.png
+    for (int i = 0; i < 24; i++) {
+        request("Resources/" + to_string(i) + ".png");
+    }
+    request("Resources/Hero - Idle.png");
+    request("Resources/Hero - Walk.png");
+    request("Resources/Goblin - Idle.png");
+    request("Resources/Goblin - Walk.png");
+    request("Resources/H_Goblin - Idle.png");
+    request("Resources/H_Goblin - Walk.png");
+    request("Resources/Slime - Idle.png");
+    request("Resources/Slime - Walk.png");
+    request("Resources/Musketeer.png");
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "GamesEngineeringBase.h"
+#include <iostream>
+#include <string>
+#include <map>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+using namespace std;
+
+// The AssetLoader decodes every image of the game on a few worker threads and keeps them in memory.
+// Before this every level restart decoded the 24 tiles, the hero and even every spawned enemy again from the png files.
+// Now an image is decoded only once per run and the hero, enemies and tiles just keep a pointer to the shared copy.
+class AssetLoader {
+    struct Asset {
+        string filename;
+        GamesEngineeringBase::Image image;
+        bool ready = false; // becomes true when a worker finished decoding the image
+    };
+
+    vector<Asset*> assets; // the handle of an asset is its index in this array
+    map<string, int> handles; // to find the handle of an already requested file
+    deque<int> pending; // handles waiting to be decoded by a worker
+    vector<thread> workers;
+    mutex lock;
+    condition_variable workAvailable; // wakes up the workers when something is queued
+    condition_variable assetReady; // wakes up get() when a worker finished an image
+    bool stopping = false;
+
+    void startWorkers();
+    void workerLoop();
+
+public:
+    AssetLoader() {}
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // queues the file for decoding and returns its handle straight away, requesting the same file again gives the same handle
+    int request(const string& filename);
+
+    // returns the decoded image, if a worker is still busy with it we wait here until it's done
+    GamesEngineeringBase::Image& get(int handle);
+    GamesEngineeringBase::Image& get(const string& filename) {
+        return get(request(filename));
+    }
+
+    // true if every requested image is decoded already
+    bool allReady();
+
+    // queues every image the game uses so they are decoded while the player is still in the console menu
+    void preloadGameAssets();
+};
+
+extern AssetLoader assetLoader; // one loader for the whole program so the images survive the level restarts
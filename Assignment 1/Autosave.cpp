@@ -0,0 +1,241 @@
+#include "Autosave.h"
+#include "Hero.h"
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <cmath>
+#include <cstring>
+
+void Autosave::writeCheckpoint(shared_ptr<GameSnapshot> snapshot) {
+    checkpoint++;
+    snapshot->checkpoint = checkpoint;
+
+    // the file is made on the writer thread, the snapshot belongs to the task now
+    SaveCodec packing = codec;
+    writer.run([this, snapshot, packing] {
+        string data, packed;
+        encodeSnapshot(*snapshot, data);
+        compressSave(data, packing, packed);
+        SaveWriter::writeFileNow(snapshotFile, packed);
+        rememberSnapshot(*snapshot);
+
+        // the journal starts again with the checksum of this snapshot, it is written even if the snapshot failed so
+        // the entries after it never end up in the journal of an older snapshot
+        SnapshotFormat::Header header;
+        memcpy(&header, data.data(), sizeof(header));
+        ostringstream start;
+        start.precision(17);
+        start << "journal " << header.checksum << " " << snapshot->projectiles.getTravelled() << "\n";
+        SaveWriter::writeFileNow(journalFile, start.str());
+    });
+
+    needCheckpoint = false;
+    checkpointTimer = 0.0f;
+    journalTimer = 0.0f;
+}
+
+void Autosave::writeJournal(shared_ptr<GameSnapshot> frame) {
+    writer.run([this, frame] { appendEntry(*frame); });
+    journalTimer = 0.0f;
+}
+
+void Autosave::rememberSnapshot(const GameSnapshot& snapshot) {
+    stamp++;
+    savedEnemies.clear();
+    const EnemyArchetype& enemies = snapshot.enemies;
+    for (unsigned int i = 0; i < enemies.size(); i++) {
+        SavedEnemy saved = { enemies.x[i], enemies.y[i], enemies.health[i], stamp };
+        savedEnemies[enemies.id[i]] = saved;
+    }
+    savedProjectiles.clear();
+    const ProjectileArchetype& projectiles = snapshot.projectiles;
+    for (unsigned int i = 0; i < projectiles.size(); i++) {
+        savedProjectiles[projectiles.serial[i]] = stamp;
+    }
+}
+
+void Autosave::appendEntry(const GameSnapshot& frame) {
+    const EnemyArchetype& enemies = frame.enemies;
+    const ProjectileArchetype& projectiles = frame.projectiles;
+    stamp++;
+    ostringstream out;
+    out.precision(9);
+    {
+        ostringstream travel;
+        travel.precision(17);
+        travel << projectiles.getTravelled();
+        out << "tick " << travel.str() << "\n";
+    }
+    Hero::saveState(out, frame.hero);
+    for (unsigned int i = 0; i < enemies.size(); i++) {
+        auto found = savedEnemies.find(enemies.id[i]);
+        if (found == savedEnemies.end()) {
+            out << "s " << enemies.id[i] << " " << (int)enemies.type[i] << " " << enemies.x[i] << " " << enemies.y[i] << " "
+                << enemies.health[i] << " " << enemies.attackTimer[i] << "\n";
+            SavedEnemy saved = { enemies.x[i], enemies.y[i], enemies.health[i], stamp };
+            savedEnemies[enemies.id[i]] = saved;
+            continue;
+        }
+        SavedEnemy& saved = found->second;
+        saved.stamp = stamp;
+        // a musketeer that stands still with the same health costs nothing, the attack timer only goes with a change
+        if (fabsf(enemies.x[i] - saved.x) > 0.5f || fabsf(enemies.y[i] - saved.y) > 0.5f || enemies.health[i] != saved.health) {
+            out << "e " << enemies.id[i] << " " << enemies.x[i] << " " << enemies.y[i] << " " << enemies.health[i] << " "
+                << enemies.attackTimer[i] << "\n";
+            saved.x = enemies.x[i];
+            saved.y = enemies.y[i];
+            saved.health = enemies.health[i];
+        }
+    }
+    for (auto it = savedEnemies.begin(); it != savedEnemies.end(); ) {
+        if (it->second.stamp != stamp) {
+            out << "r " << it->first << "\n"; // it wasn't seen alive in this autosave
+            it = savedEnemies.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    for (unsigned int i = 0; i < projectiles.size(); i++) {
+        auto found = savedProjectiles.find(projectiles.serial[i]);
+        if (found == savedProjectiles.end()) {
+            out << "p " << projectiles.serial[i] << " " << projectiles.x[i] << " " << projectiles.y[i] << " " << projectiles.dx[i] << " "
+                << projectiles.dy[i] << " " << projectiles.damage[i] << " " << (int)projectiles.fromHero[i] << "\n";
+            savedProjectiles[projectiles.serial[i]] = stamp;
+        }
+        else {
+            found->second = stamp;
+        }
+    }
+    for (auto it = savedProjectiles.begin(); it != savedProjectiles.end(); ) {
+        if (it->second != stamp) {
+            out << "q " << it->first << "\n";
+            it = savedProjectiles.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    out << "end\n";
+    SaveWriter::appendFileNow(journalFile, out.str());
+}
+
+unsigned int Autosave::applyJournal(uint64_t snapshotKey, Hero& hero, EnemyArchetype& enemies, ProjectileArchetype& projectiles,
+    const vector<EnemyType>& types) const {
+    ifstream file(journalFile, ios::binary);
+    if (!file.is_open()) {
+        return 0;
+    }
+    string word;
+    uint64_t key = 0;
+    double baseTravel = 0.0;
+    if (!(file >> word >> key >> baseTravel) || word != "journal" || key != snapshotKey) {
+        return 0; // the journal of another snapshot, the snapshot alone is used
+    }
+    string rest((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+    // the entities can be found by id, the maps are kept right when remove() moves the last one.
+    // the nodes come from an arena of this load, it gives them all back at once when we return
+    PoolArena loadArena;
+    PoolAllocator<pair<const unsigned int, unsigned int>> indexAllocator(loadArena);
+    IdMap<unsigned int> enemyIndex(enemies.size(), indexAllocator);
+    for (unsigned int i = 0; i < enemies.size(); i++) {
+        enemyIndex[enemies.id[i]] = i;
+    }
+    IdMap<unsigned int> projectileIndex(projectiles.size(), indexAllocator);
+    for (unsigned int i = 0; i < projectiles.size(); i++) {
+        projectileIndex[projectiles.serial[i]] = i;
+    }
+    IdMap<double> firedAt{ 0, PoolAllocator<pair<const unsigned int, double>>(loadArena) }; // how far the projectiles had travelled when a fired one was written
+
+    double lastTravel = baseTravel;
+    unsigned int used = 0;
+    size_t pos = 0;
+    while (true) {
+        size_t endPos = rest.find("\nend\n", pos);
+        if (endPos == string::npos) {
+            break; // the rest is empty or an entry without its end
+        }
+        istringstream entry(rest.substr(pos, endPos + 1 - pos));
+        pos = endPos + 5;
+
+        double travel = 0.0;
+        if (!(entry >> word >> travel) || word != "tick") {
+            break;
+        }
+        hero.loadState(entry);
+        while (entry >> word) {
+            unsigned int id = 0;
+            entry >> id;
+            if (word == "s") {
+                int t = 0, health = 0;
+                float ex = 0.0f, ey = 0.0f, timer = 0.0f;
+                entry >> t >> ex >> ey >> health >> timer;
+                if (t < 0 || t >= (int)types.size()) {
+                    continue;
+                }
+                unsigned int i = enemies.spawn((unsigned char)t, ex, ey, health);
+                enemies.id[i] = id;
+                enemies.attackTimer[i] = timer;
+                enemyIndex[id] = i;
+            }
+            else if (word == "e") {
+                float ex = 0.0f, ey = 0.0f, timer = 0.0f;
+                int health = 0;
+                entry >> ex >> ey >> health >> timer;
+                auto found = enemyIndex.find(id);
+                if (found != enemyIndex.end()) {
+                    unsigned int i = found->second;
+                    enemies.x[i] = ex;
+                    enemies.y[i] = ey;
+                    enemies.health[i] = health;
+                    enemies.attackTimer[i] = timer;
+                }
+            }
+            else if (word == "r") {
+                auto found = enemyIndex.find(id);
+                if (found != enemyIndex.end()) {
+                    unsigned int i = found->second;
+                    enemyIndex.erase(found);
+                    enemies.remove(i);
+                    if (i < enemies.size()) {
+                        enemyIndex[enemies.id[i]] = i; // the last enemy moved into i
+                    }
+                }
+            }
+            else if (word == "p") {
+                float px, py, pdx, pdy, dmg;
+                int fromHero;
+                entry >> px >> py >> pdx >> pdy >> dmg >> fromHero;
+                projectiles.add(px, py, pdx, pdy, dmg, fromHero != 0);
+                unsigned int i = projectiles.size() - 1;
+                projectiles.serial[i] = id;
+                projectileIndex[id] = i;
+                firedAt[id] = travel;
+            }
+            else if (word == "q") {
+                auto found = projectileIndex.find(id);
+                if (found != projectileIndex.end()) {
+                    unsigned int i = found->second;
+                    projectileIndex.erase(found);
+                    projectiles.remove(i);
+                    if (i < projectiles.size()) {
+                        projectileIndex[projectiles.serial[i]] = i;
+                    }
+                }
+            }
+        }
+        lastTravel = travel;
+        used++;
+    }
+
+    // the projectiles kept flying after they were written, they are moved to where they were at the last entry
+    for (unsigned int i = 0; i < projectiles.size(); i++) {
+        auto found = firedAt.find(projectiles.serial[i]);
+        float advance = (float)(lastTravel - ((found != firedAt.end()) ? found->second : baseTravel));
+        projectiles.x[i] += projectiles.dx[i] * advance;
+        projectiles.y[i] += projectiles.dy[i] * advance;
+    }
+    return used;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "Enemies.h"
+#include "Projectiles.h"
+#include "SaveGame.h"
+#include "SaveWriter.h"
+#include "SaveCompression.h"
+#include "PoolAllocator.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+using namespace std;
+
+// The Autosave saves the game every few seconds without writing everything again.
+// Every checkpointInterval seconds a full snapshot goes to autosave.sav and the journal starts again empty. Between
+// the checkpoints only what changed since the last autosave is added to the end of autosave.journal: the enemies that
+// spawned, died or moved, and the projectiles that were fired or removed. A projectile flies in a straight line so only
+// its start is written, where it is now comes from how far the projectiles travelled since then.
+// Loading reads the snapshot and plays the journal entries on top of it. An entry is only used if its "end" line is
+// there, so an entry that was cut off by a crash is ignored.
+// The game thread only copies the columns (like a save does), comparing them with what was saved before and writing
+// the text happens on the save thread, so the cost of an autosave doesn't grow with the number of entities.
+//
+// autosave.sav:     a normal binary save file, the header has the checkpoint number N
+// autosave.journal: "journal K <travelled>", K is the checksum of the snapshot the journal belongs to. a crash between
+//                   writing the snapshot and the new journal leaves a journal with another K, which isn't used.
+//                   then entries:
+//   tick <travelled>          the hero's 3 save lines follow
+//   s id type x y health timer    an enemy spawned
+//   e id x y health timer         an enemy changed
+//   r id                          an enemy was removed
+//   p serial x y dx dy damage fromHero    a projectile was fired, (x, y) is where it is at this tick
+//   q serial                      a projectile was removed
+//   end
+class Autosave {
+    // what the journal knows about an enemy, so only enemies that really changed are written
+    struct SavedEnemy {
+        float x, y;
+        int health;
+        unsigned int stamp; // the last autosave that saw the enemy alive
+    };
+
+    // the maps get an entry for every spawn and fired projectile and lose it again when it is removed, their nodes
+    // come from the arena instead of the heap
+    template <typename Value>
+    using IdMap = unordered_map<unsigned int, Value, hash<unsigned int>, equal_to<unsigned int>,
+        PoolAllocator<pair<const unsigned int, Value>>>;
+
+    SaveWriter& writer;
+    string snapshotFile = "autosave.sav";
+    string journalFile = "autosave.journal";
+    SaveCodec codec = CodecFast; // how the checkpoints are packed, the journal entries are too small to pack
+    float journalInterval = 5.0f; // seconds between journal entries
+    float checkpointInterval = 60.0f; // seconds between full snapshots
+    float journalTimer = 0.0f;
+    float checkpointTimer = 0.0f;
+    bool needCheckpoint = true; // nothing is saved yet, or the entities were replaced
+    unsigned int checkpoint = 0;
+
+    // only the save thread uses these, they are what the files on the disk have
+    unsigned int stamp = 0;
+    PoolArena arena; // before the maps, so it is destroyed after them
+    IdMap<SavedEnemy> savedEnemies{ 0, PoolAllocator<pair<const unsigned int, SavedEnemy>>(arena) }; // by id
+    IdMap<unsigned int> savedProjectiles{ 0, PoolAllocator<pair<const unsigned int, unsigned int>>(arena) }; // serial -> stamp
+
+    // they run on the save thread
+    void rememberSnapshot(const GameSnapshot& snapshot);
+    void appendEntry(const GameSnapshot& frame);
+
+public:
+    enum Step {
+        Nothing,
+        Journal, // the manager should call writeJournal()
+        Checkpoint // the manager should call writeCheckpoint() with a new snapshot
+    };
+
+    explicit Autosave(SaveWriter& _writer) : writer(_writer) {}
+    ~Autosave() {
+        writer.wait(); // the queued tasks use the maps
+    }
+
+    Autosave(const Autosave&) = delete;
+    Autosave& operator=(const Autosave&) = delete;
+
+    // the next update asks for a checkpoint, after a new level or a load the journal wouldn't match anymore
+    void invalidate() {
+        needCheckpoint = true;
+    }
+
+    // counts the time and says what has to be saved now
+    Step update(float dt) {
+        journalTimer += dt;
+        checkpointTimer += dt;
+        if (needCheckpoint || checkpointTimer >= checkpointInterval) {
+            return Checkpoint;
+        }
+        if (journalTimer >= journalInterval) {
+            return Journal;
+        }
+        return Nothing;
+    }
+
+    // queues the snapshot and an empty journal, what the snapshot contains is what the next entry is compared with
+    void writeCheckpoint(shared_ptr<GameSnapshot> snapshot);
+
+    // queues one entry with everything in frame that changed since the last autosave, frame is a copy of the game
+    void writeJournal(shared_ptr<GameSnapshot> frame);
+
+    void setCodec(SaveCodec _codec) {
+        codec = _codec;
+    }
+
+    const string& getSnapshotFile() const {
+        return snapshotFile;
+    }
+
+    // plays the journal on top of the loaded snapshot. snapshotKey is the checksum from the snapshot's header, a journal
+    // of another snapshot is not used. returns the number of entries that were used
+    unsigned int applyJournal(uint64_t snapshotKey, Hero& hero, EnemyArchetype& enemies, ProjectileArchetype& projectiles,
+        const vector<EnemyType>& types) const;
+};
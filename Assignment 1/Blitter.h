@@ -0,0 +1,202 @@
+#pragma once
+#include "GamesEngineeringBase.h"
+#include "DirtyTracker.h"
+#include "CoverageMask.h"
+#include <cstring>
+using namespace std;
+
+// A Surface is any block of pixels with the same layout as the canvas, for example the saved world image.
+struct Surface {
+    unsigned char* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    unsigned int pitch = 0; // bytes per row
+    unsigned int bytesPerPixel = 3;
+
+    Surface() {}
+    Surface(GamesEngineeringBase::Window& canvas)
+        : pixels(canvas.getRow(0)), width((int)canvas.getWidth()), height((int)canvas.getHeight()),
+          pitch(canvas.getPitch()), bytesPerPixel(canvas.getBytesPerPixel()) {
+    }
+
+    unsigned char* row(int y) const {
+        return pixels + y * pitch;
+    }
+    unsigned int* row32(int y) const {
+        return reinterpret_cast<unsigned int*>(pixels + y * pitch);
+    }
+};
+
+// The Blitter copies a rectangle of an image onto the canvas. The hero, the enemies and the tiles all used to do
+// this pixel by pixel with a bounds check and a canvas.draw call for every pixel, now the rectangle is clipped
+// against the screen once and every row is written in one go.
+// With a 32-bit canvas (PixelRGBX32) a pixel is a single word, so an RGBA sprite pixel is copied straight from the
+// image without repacking (the alpha byte lands in the unused fourth byte), and opaque rows are plain memcpy's.
+class Blitter {
+    // the tracker that gets told about everything drawn, nullptr when nobody tracks the dirty parts of the screen
+    static DirtyTracker*& tracker() {
+        static DirtyTracker* current = nullptr;
+        return current;
+    }
+
+public:
+    // everything drawn through the blitter is reported to this tracker from now on
+    static void setDirtyTracker(DirtyTracker* dirty) {
+        tracker() = dirty;
+    }
+
+    // for things that are not drawn with drawImage (projectiles, the AOE ring) so the tracker still knows about them
+    static void markDirty(int x, int y, int w, int h) {
+        if (tracker()) {
+            tracker()->mark(x, y, w, h);
+        }
+    }
+
+    // draws the w x h part of img that starts at (srcX, srcY) with its top left corner at (dstX, dstY) on the screen
+    // pixels with zero alpha are skipped, anything else is drawn fully like before
+    static void drawImage(GamesEngineeringBase::Window& canvas, const GamesEngineeringBase::Image& img, int srcX, int srcY, int w, int h, int dstX, int dstY) {
+        if (tracker()) {
+            tracker()->mark(dstX, dstY, w, h); // the tracker clips the rectangle itself
+        }
+        Surface target(canvas);
+        drawImage(target, img, srcX, srcY, w, h, dstX, dstY);
+    }
+
+    // same as above but draws into any surface, nothing is reported to the dirty tracker
+    static void drawImage(const Surface& target, const GamesEngineeringBase::Image& img, int srcX, int srcY, int w, int h, int dstX, int dstY) {
+        if (img.data == nullptr) {
+            return;
+        }
+        // clip the destination rectangle against the surface once instead of checking every pixel
+        int x0 = max(dstX, 0);
+        int y0 = max(dstY, 0);
+        int x1 = min(dstX + w, target.width);
+        int y1 = min(dstY + h, target.height);
+        if (x0 >= x1 || y0 >= y1) {
+            return;
+        }
+        int count = x1 - x0; // pixels per row after clipping
+        unsigned int channels = img.channels;
+
+        for (int y = y0; y < y1; y++) {
+            const unsigned char* src = img.data + (((srcY + y - dstY) * img.width) + (srcX + x0 - dstX)) * channels;
+
+            if (target.bytesPerPixel == 4) {
+                unsigned int* dst = target.row32(y) + x0;
+                if (channels == 4) {
+                    // the image is R, G, B, A in memory so one load gives the canvas word with alpha in the top byte
+                    const unsigned int* src32 = reinterpret_cast<const unsigned int*>(src);
+                    for (int i = 0; i < count; i++) {
+                        unsigned int p = src32[i];
+                        if (p >> 24) {
+                            dst[i] = p;
+                        }
+                    }
+                }
+                else {
+                    // opaque image so every pixel is written
+                    for (int i = 0; i < count; i++) {
+                        dst[i] = GamesEngineeringBase::Window::packPixel(src[0], src[1], src[2]);
+                        src += channels;
+                    }
+                }
+            }
+            else {
+                unsigned char* dst = target.row(y) + x0 * 3;
+                if (channels == 3) {
+                    memcpy(dst, src, count * 3); // the image rows already have the canvas layout
+                }
+                else {
+                    for (int i = 0; i < count; i++) {
+                        if (channels != 4 || src[3] > 0) {
+                            dst[0] = src[0];
+                            dst[1] = src[1];
+                            dst[2] = src[2];
+                        }
+                        src += channels;
+                        dst += 3;
+                    }
+                }
+            }
+        }
+    }
+
+    // the same as drawImage for a 32-bit surface, but for sprites drawn from the front to the back: only the pixels
+    // coverage doesn't have yet are written, and they are added to it. 8 covered pixels of a block row are skipped with
+    // one test and without reading the image. returns true if nothing was drawn because the sprite is completely behind
+    // the ones drawn before it, a sprite off the screen returns false
+    static bool drawImageFrontToBack(const Surface& target, const GamesEngineeringBase::Image& img, int srcX, int srcY, int w, int h,
+        int dstX, int dstY, CoverageMask& coverage) {
+        if (img.data == nullptr) {
+            return false;
+        }
+        int x0 = max(dstX, 0);
+        int y0 = max(dstY, 0);
+        int x1 = min(dstX + w, target.width);
+        int y1 = min(dstY + h, target.height);
+        if (x0 >= x1 || y0 >= y1) {
+            return false; // off the screen
+        }
+        if (coverage.rectCovered(x0, y0, x1, y1)) {
+            return true; // behind the sprites in front of it
+        }
+        unsigned int channels = img.channels;
+
+        for (int y = y0; y < y1; y++) {
+            const unsigned char* src = img.data + (((srcY + y - dstY) * img.width) + (srcX + x0 - dstX)) * channels; // the pixel at x0
+            unsigned int* dst = target.row32(y);
+            uint64_t* mask = coverage.row(y);
+            for (int base = x0 & ~63; base < x1; base += 64) {
+                // the pixels of this word that belong to the sprite and are still uncovered
+                int from = max(x0, base) - base;
+                int to = min(x1, base + 64) - base;
+                uint64_t inside = (to - from == 64) ? ~(uint64_t)0 : (((uint64_t)1 << (to - from)) - 1) << from;
+                uint64_t open = ~mask[base >> 6] & inside;
+                uint64_t drawn = 0;
+                for (int block = 0; open != 0 && block < 8; block++) {
+                    unsigned int blockOpen = (unsigned int)(open >> (block * 8)) & 0xFF;
+                    if (blockOpen == 0) {
+                        continue; // the 8 pixels of this block are covered or outside the sprite
+                    }
+                    unsigned int wrote = 0;
+                    if (blockOpen == 0xFF && channels == 4) {
+                        // nothing of these 8 pixels is covered yet, so they are copied like in drawImage without testing bits
+                        int x = base + block * 8;
+                        const unsigned int* src32 = reinterpret_cast<const unsigned int*>(src + (x - x0) * channels);
+                        for (int bit = 0; bit < 8; bit++) {
+                            unsigned int word = src32[bit];
+                            unsigned int opaque = (word >> 24) ? 1u : 0u;
+                            dst[x + bit] = opaque ? word : dst[x + bit];
+                            wrote |= opaque << bit;
+                        }
+                        blockOpen = 0; // done
+                    }
+                    for (int bit = 0; blockOpen != 0 && bit < 8; bit++) {
+                        if (!((blockOpen >> bit) & 1)) {
+                            continue;
+                        }
+                        int x = base + block * 8 + bit;
+                        const unsigned char* p = src + (x - x0) * channels;
+                        if (channels == 4) {
+                            unsigned int word = *reinterpret_cast<const unsigned int*>(p);
+                            if (word >> 24) {
+                                dst[x] = word;
+                                wrote |= 1u << bit;
+                            }
+                        }
+                        else {
+                            dst[x] = GamesEngineeringBase::Window::packPixel(p[0], p[1], p[2]);
+                            wrote |= 1u << bit;
+                        }
+                    }
+                    if (wrote) {
+                        drawn |= (uint64_t)wrote << (block * 8);
+                        coverage.addCovered(base + block * 8, y, wrote);
+                    }
+                }
+                mask[base >> 6] |= drawn;
+            }
+        }
+        return false;
+    }
+};
@@ -1,5 +1,5 @@
 #pragma once
-#include "GamesEngineeringBase.h"
+#include <cmath>
 #include <iostream>
 using namespace std;
 
@@ -30,8 +30,10 @@ public:
                 camY = worldHeight - viewHeight;
             }
         }
-        x = camX;
-        y = camY;
+        // the camera stays on whole pixels so the world and the sprites always move by whole pixels together,
+        // this also lets the renderer see exactly when the view didn't move
+        x = floorf(camX);
+        y = floorf(camY);
     }
 
     float getX() const { 
@@ -40,4 +42,11 @@ public:
     float getY() const { 
         return y; 
     }
+    // the size of the view, the manager spawns the enemies just outside of it
+    int getViewWidth() const {
+        return viewWidth;
+    }
+    int getViewHeight() const {
+        return viewHeight;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+using namespace std;
+
+// The CoverageMask remembers which screen pixels a sprite was already drawn on in this frame, one bit per pixel.
+// A row is stored in 64-bit words, so the blitter gets the covered pixels of 64 pixels with one load, and every byte of
+// a word is the row of one 8x8 block. For every block it also counts the covered pixels, so a sprite whose blocks
+// are all full is not looked at at all.
+// The sprite pixels are either drawn or not (there is no blending), so drawing the sprites from the front to the back
+// and only writing the pixels nobody covered yet gives exactly the same picture as drawing them back to front.
+class CoverageMask {
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    int blocksX = 0;
+    int blocksY = 0;
+    vector<uint64_t> bits;
+    vector<unsigned char> blockCount; // covered pixels of every block
+    vector<unsigned char> blockSize; // pixels of every block that are on the screen, 64 except at the edges
+
+public:
+    // makes the mask empty for a frame of the given size, the memory is only allocated when the size changes
+    void reset(int _width, int _height) {
+        if (_width != width || _height != height) {
+            width = _width;
+            height = _height;
+            wordsPerRow = (width + 63) / 64;
+            blocksX = (width + 7) / 8;
+            blocksY = (height + 7) / 8;
+            bits.resize((size_t)wordsPerRow * height);
+            blockCount.resize((size_t)blocksX * blocksY);
+            blockSize.resize(blockCount.size());
+            for (int by = 0; by < blocksY; by++) {
+                for (int bx = 0; bx < blocksX; bx++) {
+                    blockSize[by * blocksX + bx] = (unsigned char)(min(8, width - bx * 8) * min(8, height - by * 8));
+                }
+            }
+        }
+        fill(bits.begin(), bits.end(), 0);
+        fill(blockCount.begin(), blockCount.end(), 0);
+    }
+
+    // true if every pixel of the rectangle is covered, only whole blocks count so it can say false for a covered one
+    bool rectCovered(int x0, int y0, int x1, int y1) const {
+        for (int by = y0 >> 3; by <= (y1 - 1) >> 3; by++) {
+            for (int bx = x0 >> 3; bx <= (x1 - 1) >> 3; bx++) {
+                int b = by * blocksX + bx;
+                if (blockCount[b] != blockSize[b]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // the bits of row y, pixel x is bit x & 63 of word x >> 6
+    uint64_t* row(int y) {
+        return bits.data() + (size_t)y * wordsPerRow;
+    }
+
+    // counts the newly covered pixels (the bits of one byte of a row word) for the block of pixel (x, y).
+    // the caller sets the bits in the row itself
+    void addCovered(int x, int y, unsigned int newBits) {
+        unsigned int n = newBits - ((newBits >> 1) & 0x55); // the number of set bits in the byte
+        n = (n & 0x33) + ((n >> 2) & 0x33);
+        n = (n + (n >> 4)) & 0x0F;
+        blockCount[(y >> 3) * blocksX + (x >> 3)] += (unsigned char)n;
+    }
+};
@@ -0,0 +1,127 @@
+#pragma once
+#include "GamesEngineeringBase.h"
+#include <cstring>
+#include <vector>
+using namespace std;
+
+// The DirtyTracker remembers which pixels of the screen were drawn over the world in the last frame.
+// Every frame used to clear the screen, draw all the tiles again and upload the whole image even if the hero was
+// standing still. Now, as long as the camera doesn't move, we only copy the world image (kept by the World) back
+// under the sprites of the last frame, draw the sprites again and upload the rows that changed.
+// Every sprite reports its rectangle through mark() (the Blitter does it automatically). For each screen row we keep
+// the leftmost and rightmost dirty pixel, which is a bit more than the exact rectangles but can never overflow.
+class DirtyTracker {
+    int width = 0;
+    int height = 0;
+    unsigned int pitch = 0; // bytes per row of the canvas
+    unsigned int bytesPerPixel = 0;
+    vector<int> previousMin, previousMax; // dirty span of every row in the last frame
+    vector<int> currentMin, currentMax; // dirty span of every row in this frame
+    bool fullRedraw = true; // the world has to be drawn and uploaded completely
+    bool hasCamera = false;
+    int lastCamX = 0;
+    int lastCamY = 0;
+
+    void clearSpans(vector<int>& minX, vector<int>& maxX) {
+        for (int y = 0; y < height; y++) {
+            minX[y] = width;
+            maxX[y] = 0;
+        }
+    }
+
+public:
+    // allocates the row spans once for the size of the canvas
+    void init(GamesEngineeringBase::Window& canvas) {
+        width = canvas.getWidth();
+        height = canvas.getHeight();
+        pitch = canvas.getPitch();
+        bytesPerPixel = canvas.getBytesPerPixel();
+        previousMin.assign(height, width);
+        previousMax.assign(height, 0);
+        currentMin.assign(height, width);
+        currentMax.assign(height, 0);
+        fullRedraw = true;
+    }
+
+    // forces a full redraw on the next frame, for example when a new level starts
+    void invalidate() {
+        fullRedraw = true;
+        hasCamera = false;
+    }
+
+    // starts a frame and returns true if the world has to be drawn again because the camera scrolled
+    bool beginFrame(int camX, int camY) {
+        if (!hasCamera || camX != lastCamX || camY != lastCamY) {
+            fullRedraw = true; // the camera moved so every pixel of the world changed
+        }
+        hasCamera = true;
+        lastCamX = camX;
+        lastCamY = camY;
+
+        // the spans of the last frame are what we have to restore now
+        previousMin.swap(currentMin);
+        previousMax.swap(currentMax);
+        clearSpans(currentMin, currentMax);
+        return fullRedraw;
+    }
+
+    // called after the whole world was drawn, whatever was drawn until now is background so it doesn't count as dirty
+    void backgroundDrawn() {
+        clearSpans(currentMin, currentMax);
+    }
+
+    // copies the world image back under everything that was drawn on top of it in the last frame.
+    // the background has the same layout as the canvas
+    void restoreBackground(GamesEngineeringBase::Window& canvas, const unsigned char* background) {
+        if (!background) {
+            return;
+        }
+        for (int y = 0; y < height; y++) {
+            if (previousMin[y] >= previousMax[y]) {
+                continue; // nothing was drawn on this row
+            }
+            unsigned int offset = y * pitch + previousMin[y] * bytesPerPixel;
+            memcpy(canvas.getRow(0) + offset, background + offset, (previousMax[y] - previousMin[y]) * bytesPerPixel);
+        }
+    }
+
+    // marks a rectangle of the screen as drawn over in this frame, anything outside of the screen is ignored
+    void mark(int x, int y, int w, int h) {
+        int x0 = max(x, 0);
+        int y0 = max(y, 0);
+        int x1 = min(x + w, width);
+        int y1 = min(y + h, height);
+        if (x0 >= x1 || y0 >= y1) {
+            return;
+        }
+        for (int row = y0; row < y1; row++) {
+            if (x0 < currentMin[row]) {
+                currentMin[row] = x0;
+            }
+            if (x1 > currentMax[row]) {
+                currentMax[row] = x1;
+            }
+        }
+    }
+
+    // uploads the changed rows to the screen, which is every row after a full redraw
+    void present(GamesEngineeringBase::Window& canvas) {
+        if (fullRedraw) {
+            canvas.present();
+            fullRedraw = false;
+            return;
+        }
+        // a row changed if something was drawn on it now or was erased from it
+        int firstRow = height;
+        int lastRow = 0;
+        for (int y = 0; y < height; y++) {
+            if (previousMin[y] < previousMax[y] || currentMin[y] < currentMax[y]) {
+                if (y < firstRow) {
+                    firstRow = y;
+                }
+                lastRow = y + 1;
+            }
+        }
+        canvas.present(firstRow, lastRow);
+    }
+};
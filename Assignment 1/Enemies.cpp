@@ -1,58 +1,259 @@
 #include "Enemies.h"
-#include "Hero.h"
-#include "Manager.h"
 
-void Enemy::update(float dt, float speed, Hero& hero, Manager& manager) {
-    animTimer += dt;
-    if (animTimer > 0.15f) {
-        frame = (frame + 1) % frameCount; // we change the frame every 0.15 seconds so it creates a walking animation
-        animTimer = 0.0f; // after each frame change, we reset the timer
+bool loadEnemyTypes(const string& filename, vector<EnemyType>& types) {
+    types.clear();
+    ifstream infile(filename);
+    if (!infile.is_open()) {
+        cout << "Error: cannot open enemy file: " << filename << endl;
+        return false;
     }
 
-    linearAttackTimer += dt; // timer keeps track of how long since the enemys last attack
-    if (linearAttackTimer >= linearAttackCooldown) { // once the cooldown is over, enemy shoots a projectile 
-        float enemyCenterX = x + 16.0f;
-        float enemyCenterY = y + 22.0f;
+    string line;
+    while (getline(infile, line)) {
+        if (!line.empty() && line[line.size() - 1] == '\r') {
+            line.erase(line.size() - 1); // the file might have windows line endings
+        }
+        if (line.empty() || line[0] == '#') {
+            continue; // empty lines and comments
+        }
+        // every line is a key and a value, the value is the rest of the line because the sprite paths have spaces
+        size_t space = line.find(' ');
+        string key = line.substr(0, space);
+        string value = (space == string::npos) ? "" : line.substr(space + 1);
 
-        float heroCenterX = hero.getX() + 16.0f;
-        float heroCenterY = hero.getY() + 22.0f;
+        if (key == "enemy") {
+            types.push_back(EnemyType());
+            types.back().name = value;
+            continue;
+        }
+        if (types.empty()) {
+            cout << "Warning: " << key << " before the first enemy in " << filename << endl;
+            continue;
+        }
+        EnemyType& type = types.back();
+        stringstream number(value);
+        if (key == "idle") type.idleSprite = value;
+        else if (key == "walk") type.walkSprite = value;
+        else if (key == "health") number >> type.health;
+        else if (key == "speed") number >> type.speed;
+        else if (key == "animates") number >> type.animates;
+        else if (key == "contactDamage") number >> type.contactDamage;
+        else if (key == "contactSelfDamage") number >> type.contactSelfDamage;
+        else if (key == "score") number >> type.score;
+        else if (key == "projectileDamage") number >> type.projectileDamage;
+        else if (key == "attackCooldown") number >> type.attackCooldown;
+        else if (key == "spawnInterval") number >> type.spawnInterval;
+        else if (key == "spawnIntervalMin") number >> type.spawnIntervalMin;
+        else if (key == "spawnIntervalStep") number >> type.spawnIntervalStep;
+        else if (key == "spawnMargin") number >> type.spawnMargin;
+        else if (key == "maxAlive") number >> type.maxAlive;
+        else cout << "Warning: unknown key " << key << " in " << filename << endl;
+    }
+    infile.close();
+
+    if (types.size() > 255) {
+        types.resize(255); // the type column is one byte per enemy
+    }
+    cout << "Enemy types loaded: " << types.size() << endl;
+    return !types.empty();
+}
+
+void loadDefaultEnemyTypes(vector<EnemyType>& types) {
+    types.clear();
+    types.resize(4);
+    const int GoblinType = 0, HeavyGoblinType = 1, SlimeType = 2, MusketeerType = 3;
+
+    // Goblins are basic enemies with moderate speed and health.
+    EnemyType& goblin = types[GoblinType];
+    goblin.name = "Goblin";
+    goblin.idleSprite = "Resources/Goblin - Idle.png";
+    goblin.walkSprite = "Resources/Goblin - Walk.png";
+    goblin.health = 100;
+    goblin.speed = 80.0f; // it moves faster than heavy goblin but slower than slime
+    goblin.contactDamage = 10.0f; // collision with a goblin gives 10 damage
+    goblin.contactSelfDamage = 20.0f; // it gives them double the damage
+    goblin.score = 100;
+    goblin.spawnInterval = 4.0f; // goblin spawns most and it has the lowest threshold
+
+    // Heavy goblins move slower but have more health which makes them tank-type enemies.
+    EnemyType& heavy = types[HeavyGoblinType];
+    heavy.name = "Heavy Goblin";
+    heavy.idleSprite = "Resources/H_Goblin - Idle.png";
+    heavy.walkSprite = "Resources/H_Goblin - Walk.png";
+    heavy.health = 200;
+    heavy.speed = 40.0f; // as it is heavier it moves slower
+    heavy.contactDamage = 20.0f;
+    heavy.contactSelfDamage = 40.0f;
+    heavy.score = 200;
+    heavy.spawnInterval = 7.0f; // heavy goblins spawn least as they are harder to kill
+
+    // Slimes are small fast enemies with low health.
+    EnemyType& slime = types[SlimeType];
+    slime.name = "Slime";
+    slime.idleSprite = "Resources/Slime - Idle.png";
+    slime.walkSprite = "Resources/Slime - Walk.png";
+    slime.health = 50;
+    slime.speed = 100.0f; // as it is smaller it is the fastest
+    slime.contactDamage = 5.0f;
+    slime.contactSelfDamage = 10.0f;
+    slime.score = 50;
+    slime.spawnInterval = 6.0f; // slimes are fast so they dont spawn much
 
-        manager.spawnProjectile(enemyCenterX, enemyCenterY, heroCenterX, heroCenterY, 25, false); // each enemy projectile gives 25 damage
-        // here, enemies always target the heros center position. the last parameter false means the projectile belongs to the enemy (not the hero).
+    // Musketeers are static ranged enemies that shoot projectiles at the hero instead of moving.
+    // They use only one image since they don't walk or animate like other enemies. Also AI was used for creating the image for it
+    EnemyType& musketeer = types[MusketeerType];
+    musketeer.name = "Musketeer";
+    musketeer.idleSprite = "Resources/Musketeer.png";
+    musketeer.health = 250;
+    musketeer.speed = 0.0f; // they don't move
+    musketeer.animates = false;
+    musketeer.contactDamage = 30.0f;
+    musketeer.contactSelfDamage = 60.0f;
+    musketeer.score = 250;
+    musketeer.spawnInterval = 6.0f; // as they don't move they spawn same as slimes
+    musketeer.spawnIntervalMin = 1.5f;
+    musketeer.spawnIntervalStep = 0.1f;
+    musketeer.spawnMargin = 100.0f;
+    musketeer.projectileDamage = 30.0f; // Musketeer's attacks are stronger than regular enemies (30 vs 25 damage) as they don't move
+}
 
-        linearAttackTimer = 0.0f;
+void simulationLevelOfDetail(EnemyArchetype& enemies, float dt, float heroX, float heroY, unsigned int tick) {
+    const float midSquared = LOD_MID_DISTANCE * LOD_MID_DISTANCE; // we compare squared distances so there is no sqrt
+    const float farSquared = LOD_FAR_DISTANCE * LOD_FAR_DISTANCE;
+    for (unsigned int i = 0; i < enemies.size(); i++) {
+        float dx = heroX - enemies.x[i];
+        float dy = heroY - enemies.y[i];
+        float distanceSquared = dx * dx + dy * dy;
+        unsigned int interval = 1;
+        unsigned char detail = DetailNear;
+        if (distanceSquared > farSquared) {
+            interval = LOD_FAR_INTERVAL;
+            detail = DetailFar;
+        }
+        else if (distanceSquared > midSquared) {
+            interval = LOD_MID_INTERVAL;
+            detail = DetailMid;
+        }
+        enemies.detail[i] = detail;
+        enemies.pendingDt[i] += dt;
+        if ((tick + i) % interval == 0) {
+            enemies.stepDt[i] = enemies.pendingDt[i]; // all the time it missed is simulated now
+            enemies.pendingDt[i] = 0.0f;
+        }
+        else {
+            enemies.stepDt[i] = 0.0f;
+        }
     }
+}
 
-    float dx = hero.getX() - x; // we find the difference of location for x and y
-    float dy = hero.getY() - y; // if dx > 0 then hero is at right and if dy > 0 hero is below. these differences tell us the direction from the enemy to the hero
+void animateEnemies(EnemyArchetype& enemies, const vector<EnemyType>& types) {
+    const int frameCount = 4; // total number of animation frames in each enemy sprite
+    for (unsigned int i = 0; i < enemies.size(); i++) {
+        // far enemies are not on the screen so their animation doesn't matter
+        if (enemies.stepDt[i] == 0.0f || enemies.detail[i] == DetailFar || !types[enemies.type[i]].animates) {
+            continue;
+        }
+        enemies.animTimer[i] += enemies.stepDt[i];
+        if (enemies.animTimer[i] > 0.15f) {
+            enemies.frame[i] = (enemies.frame[i] + 1) % frameCount; // we change the frame every 0.15 seconds so it creates a walking animation
+            enemies.animTimer[i] = 0.0f; // after each frame change, we reset the timer
+        }
+    }
+}
 
-    float length = sqrt(dx * dx + dy * dy); // the lenght is the square root of the sum of the squares of the difference of x and y
-    // this gives us the actual distance between enemy and hero
+void separateEnemies(const EnemyArchetype& enemies, const vector<EnemyType>& types, const SpatialGrid& grid, vector<float>& pushX,
+    vector<float>& pushY) {
+    const float radius = SEPARATION_RADIUS;
+    const float radiusSquared = radius * radius;
+    const float inverseRadius = 1.0f / radius;
+    pushX.assign(enemies.size(), 0.0f); // the vectors keep their capacity
+    pushY.assign(enemies.size(), 0.0f);
+    float nx[SEPARATION_NEIGHBOURS], ny[SEPARATION_NEIGHBOURS], tieBreak[SEPARATION_NEIGHBOURS];
+    for (unsigned int i = 0; i < enemies.size(); i++) {
+        if (enemies.stepDt[i] == 0.0f || enemies.detail[i] == DetailFar || types[enemies.type[i]].speed == 0.0f) {
+            continue;
+        }
+        float px = enemies.x[i];
+        float py = enemies.y[i];
+        unsigned int found = 0;
+        grid.forEachInRectWhile(px - radius, py - radius, px + radius, py + radius, [&](int j, float jx, float jy) {
+            float dx = px - jx;
+            float dy = py - jy;
+            if ((unsigned int)j != i && dx * dx + dy * dy < radiusSquared) { // the corners of the square don't count
+                nx[found] = jx;
+                ny[found] = jy;
+                tieBreak[found] = (enemies.id[j] < enemies.id[i]) ? 1.0f : -1.0f;
+                found++;
+            }
+            return found < SEPARATION_NEIGHBOURS;
+        });
 
-    if (length > 0.01f) { //if there is a small bit of difference it has to move
-        dx /= length; // we normalize them
-        dy /= length;
-        // dividing by length gives a direction vector of length 1
-        x += dx * speed * dt; // and at the end we change the x coordinate by the speed as dx and dy might take positive or negative values it will move to the correct position
-        y += dy * speed * dt;
-        // multiplying by speed and dt makes the enemy move smoothly toward the hero at a consistent rate
+        // the neighbours are in small arrays now, this loop has no branches so the compiler can vectorize it.
+        // the push of one neighbour is (r / d - d / r) along the direction away from it: strong when they overlap and 0 at
+        // the radius. d * (r / d^2 - 1 / r) gives that without a sqrt
+        float sx = 0.0f, sy = 0.0f;
+        for (unsigned int k = 0; k < found; k++) {
+            float dx = px - nx[k];
+            float dy = py - ny[k];
+            float d2 = dx * dx + dy * dy;
+            bool same = d2 < 0.0001f; // two enemies on the same spot are split along x, the newer one (larger id) goes right
+            dx = same ? tieBreak[k] : dx;
+            d2 = same ? 1.0f : d2;
+            float weight = radius / d2 - inverseRadius;
+            sx += dx * weight;
+            sy += dy * weight;
+        }
+        pushX[i] = sx;
+        pushY[i] = sy;
     }
 }
 
+void moveEnemies(EnemyArchetype& enemies, const vector<EnemyType>& types, float heroX, float heroY, const vector<float>& pushX,
+    const vector<float>& pushY) {
+    for (unsigned int i = 0; i < enemies.size(); i++) {
+        float speed = types[enemies.type[i]].speed;
+        float dt = enemies.stepDt[i];
+        if (speed == 0.0f || dt == 0.0f) {
+            continue;
+        }
+        float dx = heroX - enemies.x[i]; // if dx > 0 then hero is at right and if dy > 0 hero is below
+        float dy = heroY - enemies.y[i];
 
-// Musketeer enemies are stationary ranged attackers that shoot projectiles to the hero. They dont move like other enemies.
-void Musketeer::update(float dt, float speed, Hero& hero, Manager& manager) {
-    linearAttackTimer += dt; // counts time between shots
-    if (linearAttackTimer >= linearAttackCooldown) // if enough time has passed, they shoot again
-    {
-        float enemyCenterX = x + 16.0f;
-        float enemyCenterY = y + 22.0f;
-        float heroCenterX = hero.getX() + 16.0f;
-        float heroCenterY = hero.getY() + 22.0f;
+        float length = sqrt(dx * dx + dy * dy); // this gives us the actual distance between enemy and hero
+        float step = speed * dt;
 
-        manager.spawnProjectile(enemyCenterX, enemyCenterY, heroCenterX, heroCenterY, 30, false); // each enemy projectile gives 30 damage
-        // Musketeers attacks are stronger than regular enemies (30 vs 25 damage) as they dont move their role is to pressure the player from a distance.
+        float moveX = 0.0f, moveY = 0.0f;
+        if (length > 0.01f) { //if there is a small bit of difference it has to move
+            // dividing by length gives a direction vector of length 1, a long step must not jump over the hero
+            float toHero = min(step, length) / length;
+            moveX = dx * toHero;
+            moveY = dy * toHero;
+        }
+        // the push from the neighbours comes on top, but together they are never faster than the speed of the type
+        moveX += pushX[i] * SEPARATION_STRENGTH * step;
+        moveY += pushY[i] * SEPARATION_STRENGTH * step;
+        float moveSquared = moveX * moveX + moveY * moveY;
+        if (moveSquared > step * step) {
+            float scale = step / sqrt(moveSquared);
+            moveX *= scale;
+            moveY *= scale;
+        }
+        enemies.x[i] += moveX;
+        enemies.y[i] += moveY;
+    }
+}
 
-        linearAttackTimer = 0.0f;
+void enemyAttacks(EnemyArchetype& enemies, const vector<EnemyType>& types, vector<unsigned int>& fireList) {
+    fireList.clear();
+    for (unsigned int i = 0; i < enemies.size(); i++) {
+        enemies.attackTimer[i] += enemies.stepDt[i]; // timer keeps track of how long since the enemy's last attack
+        if (enemies.attackTimer[i] >= types[enemies.type[i]].attackCooldown) { // once the cooldown is over, enemy shoots a projectile
+            fireList.push_back(i);
+            enemies.attackTimer[i] = 0.0f;
+        }
     }
 }
+
+void loadEnemy(EnemyArchetype& enemies, unsigned int i, istream& file) {
+    file >> enemies.x[i] >> enemies.y[i] >> enemies.health[i] >> enemies.attackTimer[i];
+}
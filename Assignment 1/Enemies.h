@@ -1,173 +1,263 @@
 #pragma once
-#include "GamesEngineeringBase.h"
-#include "Camera.h"
+#include "Entities.h"
+#include "SpatialGrid.h"
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
 using namespace std;
-class Hero;
-class Manager;
-
-// Base Enemy Class which all enemies inherits from it
-class Enemy {
-protected:
-    float x, y; // the current position of the enemy in the world
-    GamesEngineeringBase::Image idleImage; // the idle image is shown when the enemy is not moving
-    GamesEngineeringBase::Image walkingImage; // the walking image is used when the enemy is moving towards the hero
-    GamesEngineeringBase::Image* currentImage; // a pointer to whichever image should currently be displayed
-    int frame = 0; 
-    int health; // current health value of the enemy
-    const int frameWidth = 32; // width of each frame in the enemy sprite
-    const int frameHeight = 32; // height of each frame in the enemy sprite
-    float animTimer = 0.0f; // timer used to control animation speed
-    float linearAttackTimer = 0.0f; // counts how long since the enemy last attacked
-    float linearAttackCooldown = 3.0f; // enemy can attack once every 3 seconds
-    const int frameCount = 4; // total number of animation frames in each enemy sprite
 
-public:
-    // default constructor initializes x-y health and sets the current image to idle image
-    Enemy() {
-        x = 0;
-        y = 0;
-        health = 100;
-        currentImage = &idleImage;
-    }
-
-    Enemy(float _x, float _y, const std::string& idleFile, const std::string& walkFile, int _health) {
-        if (!idleFile.empty()) { // load the idle sprite if it's loadable
-            idleImage.load(idleFile);
-        }
-        if (!walkFile.empty()) { // load the walking sprite if it's loadable
-            walkingImage.load(walkFile);
-        }
-        currentImage = &idleImage; // current pointer points to idle image
-        x = _x;
-        y = _y;
-        health = _health;
-    }
+// Everything that is the same for all enemies of one type. Goblins, heavy goblins, slimes and musketeers used to be
+// four classes and the manager had four copies of every loop and four spawn functions, now an enemy is just a row in
+// the EnemyArchetype and the type column points into a table of these. The table is read from Resources/enemies.txt
+// so a new enemy type only needs a new block in that file (and its sprites).
+struct EnemyType {
+    string name;
+    string idleSprite; // the idle image is shown for the enemy, the ActorRenderer loads it
+    string walkSprite; // only the types that walk have one
+    int health = 100; // the health an enemy of this type spawns with
+    float speed = 0.0f; // 0 means the enemy doesn't move, like the musketeers
+    bool animates = true; // the musketeer image has only one frame
+    float contactDamage = 0.0f; // what the hero gets when touching the enemy
+    float contactSelfDamage = 0.0f; // and what the enemy gets back
+    int score = 0; // what the hero gets for killing one
+    float projectileDamage = 25.0f; // the damage of the projectiles it shoots
+    float attackCooldown = 3.0f; // enemy can attack once every 3 seconds
+    float spawnInterval = 5.0f; // seconds between two spawns at the start of a level
+    float spawnIntervalMin = 0.5f; // the spawns never come faster than this
+    float spawnIntervalStep = 0.2f; // every spawn makes the next one come this much sooner
+    float spawnMargin = 32.0f; // how far outside of the view the enemy appears
+    unsigned int maxAlive = 1000; // they have their own capacities, the wave director also has one for all types
+};
 
-    // the update function is virtual which allows Musketeer to override it
-    virtual void update(float dt, float speed, Hero& hero, Manager& manager);
+// reads the enemy types from the file, returns false (and leaves types empty) if the file can't be read
+bool loadEnemyTypes(const string& filename, vector<EnemyType>& types);
+// the types the game was made with, used if the file is missing
+void loadDefaultEnemyTypes(vector<EnemyType>& types);
 
-    // the draw function renders the enemy sprite on the screen with camera offset applied
-    void draw(GamesEngineeringBase::Window& canvas, Camera& camera) {
-        GamesEngineeringBase::Image& img = *currentImage; // we pick the correct image to draw
-        if (img.width == 0 || img.height == 0) { // we only draw if the image was successfully loaded
-            return;
-        }
+// The EnemyArchetype stores all the enemies as columns, one vector for every component, and enemy i is the i-th element
+// of every column. A system only walks the columns it needs (the movement only touches x, y and type) so the loops
+// read memory in order instead of jumping between enemies that were allocated one by one.
+// Removing an enemy moves the last one into its place so the columns always stay dense.
+class EnemyArchetype {
+    unsigned int count = 0;
+    vector<unsigned int> countOfType; // how many enemies of every type are alive
 
-        int startX = frame * frameWidth; // determines which part of the sprite sheet to display
+public:
+    // position, the top left corner of the sprite
+    vector<float> x, y;
+    // health
+    vector<int> health;
+    // animation
+    vector<int> frame;
+    vector<float> animTimer;
+    // attack cooldown, counts how long since the enemy last attacked
+    vector<float> attackTimer;
+    // which row of the type table this enemy uses
+    vector<unsigned char> type;
+    // simulation level of detail: the time that passed since the enemy was last simulated, the time it is simulated
+    // for in this tick (0 if it is skipped) and how detailed it is simulated (see SimulationDetail)
+    vector<float> pendingDt;
+    vector<float> stepDt;
+    vector<unsigned char> detail;
+    // stays the same while the enemy lives even when it moves to another index, the autosave journal uses it
+    vector<unsigned int> id;
+    unsigned int nextId = 0;
 
-        if (startX + frameWidth > img.width) { // it selects the correct starting point for the animations. If it's the third frame then the starting point becomes 2 x 32 = 64.
-            return;
-        }
+    unsigned int size() const {
+        return count;
+    }
 
-        // loops through every pixel in the frame and draws it if it's visible on screen
-        for (int i = 0; i < frameHeight; ++i) {
-            for (int j = 0; j < frameWidth; ++j) {
-                int xVal = (int)(x - camera.getX()) + j; // offset x based on camera position
-                int yVal = (int)(y - camera.getY()) + i; // offset y based on camera position
-
-                // skip drawing if outside the visible area of the screen
-                if (xVal < 0 || yVal < 0 || xVal >= (int)canvas.getWidth() || yVal >= (int)canvas.getHeight()) {
-                    continue;
-                }
-
-                // draw 
-                if (img.alphaAtUnchecked(startX + j, i) > 0) {
-                    canvas.draw(xVal, yVal, img.atUnchecked(startX + j, i));
-                }
-            }
-        }
+    unsigned int sizeOfType(unsigned int t) const {
+        return (t < countOfType.size()) ? countOfType[t] : 0;
     }
 
-    // simple move function that updates the enemy's position based on dx and dy
-    void move(float dx, float dy) {
-        x += dx;
-        y += dy;
+    // makes room for n enemies so spawning never allocates
+    void reserve(unsigned int n) {
+        x.reserve(n);
+        y.reserve(n);
+        health.reserve(n);
+        frame.reserve(n);
+        animTimer.reserve(n);
+        attackTimer.reserve(n);
+        type.reserve(n);
+        pendingDt.reserve(n);
+        stepDt.reserve(n);
+        detail.reserve(n);
+        id.reserve(n);
     }
 
-    // returns the current health value of the enemy
-    int getHealth() { 
-        return health;
+    // adds an enemy and returns its index
+    unsigned int spawn(unsigned char t, float _x, float _y, int _health) {
+        x.push_back(_x);
+        y.push_back(_y);
+        health.push_back(_health);
+        frame.push_back(0);
+        animTimer.push_back(0.0f);
+        attackTimer.push_back(0.0f);
+        type.push_back(t);
+        pendingDt.push_back(0.0f);
+        stepDt.push_back(0.0f);
+        detail.push_back(0);
+        id.push_back(nextId++);
+        if (t >= countOfType.size()) {
+            countOfType.resize(t + 1, 0);
+        }
+        countOfType[t]++;
+        return count++;
     }
 
-    // getter functions for position
-    float getY() { 
-        return y;
-    };
-    float getX() {
-        return x;
-    };
-
-    // checks if the enemy is dead
-    bool isDead() {
-        if (health <= 0) {
-            return true;
+    // adds count enemies of the same type at once, every column grows only once
+    void spawnBatch(unsigned char t, unsigned int n, const float* xs, const float* ys, int _health) {
+        unsigned int newCount = count + n;
+        x.insert(x.end(), xs, xs + n);
+        y.insert(y.end(), ys, ys + n);
+        health.resize(newCount, _health);
+        frame.resize(newCount, 0);
+        animTimer.resize(newCount, 0.0f);
+        attackTimer.resize(newCount, 0.0f);
+        type.resize(newCount, t);
+        pendingDt.resize(newCount, 0.0f);
+        stepDt.resize(newCount, 0.0f);
+        detail.resize(newCount, 0);
+        id.resize(newCount);
+        for (unsigned int i = count; i < newCount; i++) {
+            id[i] = nextId++;
         }
-        else {
-            return false;
+        if (t >= countOfType.size()) {
+            countOfType.resize(t + 1, 0);
         }
+        countOfType[t] += n;
+        count = newCount;
     }
 
-    // applies damage to the enemy and ensures health doesn't go below zero
-    void getDamage(float damage) {
-        health -= damage;
-        if (health < 0) {
-            health = 0;
-        }         
+    // replaces every enemy with n loaded ones, the saved columns are copied in as they are.
+    // the columns that aren't saved start like a new spawn
+    void assignColumns(unsigned int n, const float* xs, const float* ys, const int32_t* healths, const float* attackTimers,
+        const unsigned char* types, const unsigned int* ids) {
+        x.assign(xs, xs + n);
+        y.assign(ys, ys + n);
+        health.assign(healths, healths + n);
+        attackTimer.assign(attackTimers, attackTimers + n);
+        type.assign(types, types + n);
+        id.assign(ids, ids + n);
+        frame.assign(n, 0);
+        animTimer.assign(n, 0.0f);
+        pendingDt.assign(n, 0.0f);
+        stepDt.assign(n, 0.0f);
+        detail.assign(n, 0);
+        for (unsigned int t = 0; t < countOfType.size(); t++) {
+            countOfType[t] = 0;
+        }
+        for (unsigned int i = 0; i < n; i++) {
+            if (types[i] >= countOfType.size()) {
+                countOfType.resize(types[i] + 1, 0);
+            }
+            countOfType[types[i]]++;
+        }
+        count = n;
     }
 
-    // saves the state of the enemy to a file
-    virtual void saveState(ofstream& file) {
-        file << x << " " << y << " " << health << " " << linearAttackTimer << "\n";
+    // removes enemy i, the last enemy takes its index
+    void remove(unsigned int i) {
+        countOfType[type[i]]--;
+        unsigned int last = count - 1;
+        if (i != last) {
+            x[i] = x[last];
+            y[i] = y[last];
+            health[i] = health[last];
+            frame[i] = frame[last];
+            animTimer[i] = animTimer[last];
+            attackTimer[i] = attackTimer[last];
+            type[i] = type[last];
+            pendingDt[i] = pendingDt[last];
+            stepDt[i] = stepDt[last];
+            detail[i] = detail[last];
+            id[i] = id[last];
+        }
+        x.pop_back();
+        y.pop_back();
+        health.pop_back();
+        frame.pop_back();
+        animTimer.pop_back();
+        attackTimer.pop_back();
+        type.pop_back();
+        pendingDt.pop_back();
+        stepDt.pop_back();
+        detail.pop_back();
+        id.pop_back();
+        count--;
     }
 
-    // loads the saved state back into the enemy
-    virtual void loadState(ifstream& file) {
-        file >> x >> y >> health >> linearAttackTimer;
+    void clear() {
+        x.clear();
+        y.clear();
+        health.clear();
+        frame.clear();
+        animTimer.clear();
+        attackTimer.clear();
+        type.clear();
+        pendingDt.clear();
+        stepDt.clear();
+        detail.clear();
+        id.clear();
+        for (unsigned int t = 0; t < countOfType.size(); t++) {
+            countOfType[t] = 0;
+        }
+        count = 0;
     }
-};
-
 
-// Goblin class inherits from Enemy
-// Goblins are basic enemies with moderate speed and health.
-class Goblin : public Enemy {
-public:
-    Goblin(float _x, float _y, const std::string& idleFile, const std::string& walkFile)
-        : Enemy(_x, _y, idleFile, walkFile, 100) { // it has 100 health
+    // applies damage to enemy i and ensures health doesn't go below zero
+    void damage(unsigned int i, float amount) {
+        health[i] -= amount;
+        if (health[i] < 0) {
+            health[i] = 0;
+        }
     }
-};
-
 
-// HeavyGoblin class inherits from Enemy
-// Heavy goblins move slower but have more health which makes them tank-type enemies.
-class HeavyGoblin : public Enemy {
-public:
-    HeavyGoblin(float _x, float _y, const std::string& idleFile, const std::string& walkFile)
-        : Enemy(_x, _y, idleFile, walkFile, 200) { // it has 200 health
+    bool isDead(unsigned int i) const {
+        return health[i] <= 0;
     }
 };
 
-
-// Slime class inherits from Enemy
-// Slimes are small fast enemies with low health but spawn more frequently.
-class Slime : public Enemy {
-public:
-    Slime(float _x, float _y, const std::string& idleFile, const std::string& walkFile)
-        : Enemy(_x, _y, idleFile, walkFile, 50) { // it has 50 health
-    }
+// How often an enemy is simulated depends on how far it is from the hero. Enemies that are far away and off the
+// screen don't need to be updated every frame, they collect the time they missed and are simulated for all of it at
+// once, so they still walk at the same speed and shoot at the same rate and arrive at the hero at the same time.
+enum SimulationDetail {
+    DetailNear = 0, // every tick
+    DetailMid = 1, // every other tick
+    DetailFar = 2 // every 8th tick and without animation
 };
+const float LOD_MID_DISTANCE = 900.0f; // further than this from the hero is mid detail, a bit more than the view
+const float LOD_FAR_DISTANCE = 1800.0f; // and further than this is far
+const unsigned int LOD_MID_INTERVAL = 2;
+const unsigned int LOD_FAR_INTERVAL = 8;
 
+// Every enemy walks to the same point, so without anything else a swarm ends up as one blob where hundreds of sprites
+// are drawn on the same pixels. Enemies closer than SEPARATION_RADIUS push each other apart (like the separation
+// rule of boids), and only the first SEPARATION_NEIGHBOURS the grid finds count, so a blob can't make it quadratic.
+const float SEPARATION_RADIUS = 24.0f; // the sprites are 32 pixels wide, a bit of overlap still looks like a crowd
+const unsigned int SEPARATION_NEIGHBOURS = 8;
+const float SEPARATION_STRENGTH = 1.0f; // 1 lets an overlapping enemy spend its whole step on getting out
 
-// Musketeer class inherits from Enemy
-// Musketeers are static ranged enemies that shoot projectiles at the hero instead of moving.
-// They use only one image since they don't walk or animate like other enemies. Also AI was used for creating the image for it
-class Musketeer : public Enemy {
-public:
-    Musketeer(float _x, float _y, const std::string& idleFile, int _health)
-        : Enemy(_x, _y, idleFile, "", _health) {
-    }
+// The systems, each one runs over every enemy but only for the components it needs. They are in Enemies.cpp.
 
-    // overrides update since Musketeers do not move but attack at intervals
-    void update(float dt, float speed, Hero& hero, Manager& manager);
-};
+// decides which enemies are simulated in this tick and for how long (stepDt), this runs before the other systems.
+// the enemies are spread over the ticks by their index so the far ones don't all update in the same frame
+void simulationLevelOfDetail(EnemyArchetype& enemies, float dt, float heroX, float heroY, unsigned int tick);
+
+// the systems below use the stepDt of every enemy instead of the frame time
+// changes the frame every 0.15 seconds so it creates a walking animation
+void animateEnemies(EnemyArchetype& enemies, const vector<EnemyType>& types);
+// how much every enemy is pushed away from its neighbours, grid has the enemies by index (from the last rebuild).
+// the far enemies and the ones that don't move or aren't simulated in this tick get no push
+void separateEnemies(const EnemyArchetype& enemies, const vector<EnemyType>& types, const SpatialGrid& grid, vector<float>& pushX,
+    vector<float>& pushY);
+// moves every enemy towards the hero with the speed of its type, plus the push from separateEnemies
+void moveEnemies(EnemyArchetype& enemies, const vector<EnemyType>& types, float heroX, float heroY, const vector<float>& pushX,
+    const vector<float>& pushY);
+// collects the enemies whose cooldown is over into fireList, the manager fires all of their projectiles at once
+void enemyAttacks(EnemyArchetype& enemies, const vector<EnemyType>& types, vector<unsigned int>& fireList);
+// loads one enemy of the old text save, the line is: x y health attack timer
+void loadEnemy(EnemyArchetype& enemies, unsigned int i, istream& file);
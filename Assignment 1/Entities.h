@@ -0,0 +1,35 @@
+#pragma once
+#include <cmath>
+using namespace std;
+
+// Small pieces of the simulation that the hero, the enemies and the projectiles share. Nothing here draws, the sprite
+// sheets are in SpriteSheet.h on the drawing side.
+
+// a circle moving from (x0, y0) by (mx, my) during the tick against a circle that stands still at (cx, cy). it returns
+// true if they touch at some point of the movement and hitTime tells when, 0 is the start of the movement and 1 the
+// end. a fast projectile can't jump over an enemy between two frames this way
+inline bool sweptCircleHit(float x0, float y0, float mx, float my, float cx, float cy, float combinedRadius, float& hitTime) {
+    float fx = x0 - cx;
+    float fy = y0 - cy;
+    float c = fx * fx + fy * fy - combinedRadius * combinedRadius;
+    if (c < 0.0f) {
+        hitTime = 0.0f; // they already overlap at the start
+        return true;
+    }
+    float a = mx * mx + my * my;
+    float b = fx * mx + fy * my;
+    if (a == 0.0f || b >= 0.0f) {
+        return false; // not moving, or moving away from the circle
+    }
+    // the first time the distance is exactly the radius, from |f + t * m|^2 = r^2
+    float discriminant = b * b - a * c;
+    if (discriminant < 0.0f) {
+        return false; // the line passes next to the circle
+    }
+    float t = (-b - sqrt(discriminant)) / a;
+    if (t > 1.0f) {
+        return false; // it would only reach the circle in a later tick
+    }
+    hitTime = t;
+    return true;
+}
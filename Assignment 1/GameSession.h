@@ -0,0 +1,91 @@
+#pragma once
+#include "GamesEngineeringBase.h"
+#include "Camera.h"
+#include "Hero.h"
+#include "Manager.h"
+#include "World.h"
+#include "WorldRenderer.h"
+#include "ActorRenderer.h"
+#include "DirtyTracker.h"
+#include "Blitter.h"
+#include "RenderQueue.h"
+#include "Random.h"
+#include "InputState.h"
+using namespace std;
+
+// The GameSession owns everything that lives for the whole run: the window with its D3D device and shaders,
+// the world map, the hero and the manager with its projectile array, and the renderers that draw them.
+// Before this main.cpp created all of them again for every level, now a level transition only calls reset()
+// which puts the gameplay state back to the start without creating a window or allocating anything.
+class GameSession {
+public:
+    GamesEngineeringBase::Window canvas;
+    GamesEngineeringBase::Timer timer;
+    Camera camera;
+    Hero hero;
+    Manager manager;
+    World world;
+    WorldRenderer worldRenderer; // the tile images and the last drawn view of the world
+    ActorRenderer actorRenderer; // the sprites of the hero and the enemies, and the projectiles
+    DirtyTracker dirty; // knows which parts of the screen changed since the last frame
+    RenderQueue sprites; // the hero and enemy sprites of a frame, sorted before they are drawn
+    RandomService random; // every random number of the run comes from its seed
+    bool isInfinite = false;
+    uint32_t attempt = 0; // the attempt of the level that is played, it goes into the random stream
+    uint32_t nextAttempt = 0; // a replay sets it to the attempt it was recorded in
+
+    explicit GameSession(uint64_t seed)
+        : camera(1024, 768, 1344, 1344),
+          hero(500, 400),
+          world("Resources/tiles.txt"),
+          worldRenderer(world),
+          actorRenderer(manager, "Resources/Hero - Idle.png", "Resources/Hero - Walk.png"),
+          random(seed) {
+        canvas.create(1024, 768, "Survivor Game", false, 0, 0, GamesEngineeringBase::PixelRGBX32); // 32-bit pixels so the blitters write whole words
+        dirty.init(canvas);
+        Blitter::setDirtyTracker(&dirty);
+    }
+
+    ~GameSession() {
+        Blitter::setDirtyTracker(nullptr);
+    }
+
+    // the keys that are down in the window, checkInput() should have been called before
+    InputState readInput() const {
+        static_assert(KeyEscape == VK_ESCAPE, "the input keys use the window's key codes");
+        InputState input;
+        for (int bit = 0; bit < InputState::keyCount; bit++) {
+            input.setKey(InputState::keyAt(bit), canvas.keyPressed(InputState::keyAt(bit)));
+        }
+        return input;
+    }
+
+    // starts a new level in the given world mode, the hero and all the enemies are back to their starting state
+    void reset(bool infinite, int level = 1) {
+        isInfinite = infinite;
+        hero.reset(500, 400);
+        manager.reset(level);
+        attempt = nextAttempt++;
+        manager.seedRandom(random, level, attempt);
+        camera.update(hero.getX(), hero.getY(), isInfinite);
+        dirty.invalidate(); // the first frame of a level draws everything
+        canvas.resetInput(); // keys held down before the menu (like ESC) shouldn't count in the new level
+        timer.reset(); // the time spent in the console menu is not part of the first frame
+    }
+
+    // starts a level from the save file, the world mode comes from the save
+    void loadSaved() {
+        reset(false);
+        manager.loadGame(hero, isInfinite);
+        random.setSeed(manager.getSessionSeed()); // the levels after it continue the saved run
+        camera.update(hero.getX(), hero.getY(), isInfinite);
+    }
+
+    // starts a level from the last autosave
+    void loadAutosaved() {
+        reset(false);
+        manager.loadAutosave(hero, isInfinite);
+        random.setSeed(manager.getSessionSeed());
+        camera.update(hero.getX(), hero.getY(), isInfinite);
+    }
+};
@@ -62,6 +62,15 @@ namespace GamesEngineeringBase
 		MouseRight = 2
 	};
 
+	// Enum for the back buffer layout
+	// PixelRGB24 packs three bytes per pixel, PixelRGBX32 stores one 32-bit word per pixel (bytes R, G, B, unused)
+	// with every row aligned to 32 bytes, so whole pixels can be written with aligned word or vector stores
+	enum PixelFormat
+	{
+		PixelRGB24 = 0,
+		PixelRGBX32 = 1
+	};
+
 	// The Window class manages the creation and rendering of a window
 	class Window
 	{
@@ -88,6 +97,8 @@ namespace GamesEngineeringBase
 		unsigned int width = 0;                  // Window width
 		unsigned int height = 0;                 // Window height
 		unsigned int paddedDataSize = 0;         // Padding for backbuffer memory allocation
+		unsigned int bytesPerPixel = 3;          // 3 for PixelRGB24, 4 for PixelRGBX32
+		unsigned int pitch = 0;                  // Bytes from the start of one row to the start of the next
 
 		// Static window procedure to handle window messages
 		static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
@@ -217,7 +228,7 @@ namespace GamesEngineeringBase
 
 	public:
 		// Creates and initializes the window
-		void create(unsigned int window_width, unsigned int window_height, const std::string window_name, bool window_fullscreen = false, int window_x = 0, int window_y = 0)
+		void create(unsigned int window_width, unsigned int window_height, const std::string window_name, bool window_fullscreen = false, int window_x = 0, int window_y = 0, PixelFormat format = PixelRGB24)
 		{
 			// Window class structure
 			WNDCLASSEX wc;
@@ -347,7 +358,19 @@ namespace GamesEngineeringBase
 			devcontext->OMSetRenderTargets(1, &rtv, NULL);
 
 			// Calculate padding for GPU alignment
-			unsigned int dataSize = width * height * 3;
+			unsigned int dataSize;
+			if (format == PixelRGBX32)
+			{
+				// Rows are padded to a multiple of 8 pixels so every row starts on a 32 byte boundary
+				bytesPerPixel = 4;
+				pitch = ((width + 7) & ~7u) * 4;
+				dataSize = pitch * height;
+			} else
+			{
+				bytesPerPixel = 3;
+				pitch = width * 3;
+				dataSize = width * height * 3;
+			}
 			paddedDataSize = ((dataSize + 3) / 4) * 4;
 
 			// Create buffer to hold the back buffer image
@@ -388,7 +411,19 @@ namespace GamesEngineeringBase
             }";
 
 			// Width is fixed so we can write it into the shader code at compile time
-			std::string pixelShader = "ByteAddressBuffer buf : register(t0);\
+			std::string pixelShader = (bytesPerPixel == 4) ? "ByteAddressBuffer buf : register(t0);\
+            struct VSOut\
+            {\
+                float4 pos : SV_Position;\
+            };\
+            float4 PS(VSOut psInput) : SV_Target0\
+            {\
+				uint data = buf.Load((int(psInput.pos.y) * WIDTH) + (int(psInput.pos.x) * 4));\
+				float r = (data & 0xFF) / 255.0;\
+				float g = ((data >> 8) & 0xFF) / 255.0; \
+				float b = ((data >> 16) & 0xFF) / 255.0; \
+                return float4(r, g, b, 1.0f);\
+            }" : "ByteAddressBuffer buf : register(t0);\
             struct VSOut\
             {\
                 float4 pos : SV_Position;\
@@ -413,7 +448,7 @@ namespace GamesEngineeringBase
                 return float4(r, g, b, 1.0f);\
             }";
 			unsigned int startPos = 0;
-			std::string widthStr = std::to_string(width);
+			std::string widthStr = std::to_string((bytesPerPixel == 4) ? pitch : width); // The 32-bit shader addresses rows by their byte pitch
 			std::string widthConst = "WIDTH";
 			startPos = static_cast<unsigned int>(pixelShader.find(widthConst, startPos));
 			pixelShader.replace(startPos, widthConst.length(), widthStr);
@@ -458,8 +493,8 @@ namespace GamesEngineeringBase
 			devcontext->PSSetShader(ps, NULL, 0);
 			devcontext->PSSetShaderResources(0, 1, &srv);
 
-			// Allocate memory for the back buffer image data
-			image = new unsigned char[paddedDataSize];
+			// Allocate memory for the back buffer image data, aligned so rows can be written with vector stores
+			image = static_cast<unsigned char*>(_aligned_malloc(paddedDataSize, 32));
 			clear(); // Clear the image data
 
 			// Initialize input states
@@ -477,16 +512,35 @@ namespace GamesEngineeringBase
 			pumpLoop();
 		}
 
+		// Releases all keys and mouse buttons, used when a window is reused after the game was paused in the console
+		void resetInput()
+		{
+			pumpLoop();
+			memset(keys, 0, 256 * sizeof(bool));
+			memset(mouseButtons, 0, 3 * sizeof(bool));
+		}
+
 		// Returns a pointer to the back buffer image data
 		unsigned char* backBuffer() const
 		{
 			return image;
 		}
 
+		// Packs an RGB color into the 32-bit pixel word used by PixelRGBX32
+		static unsigned int packPixel(unsigned char r, unsigned char g, unsigned char b)
+		{
+			return static_cast<unsigned int>(r) | (static_cast<unsigned int>(g) << 8) | (static_cast<unsigned int>(b) << 16);
+		}
+
 		// Draws a pixel at (x, y) with the specified RGB color
 		void draw(int x, int y, unsigned char r, unsigned char g, unsigned char b)
 		{
-			int index = ((y * width) + x) * 3;
+			if (bytesPerPixel == 4)
+			{
+				reinterpret_cast<unsigned int*>(image + (y * pitch))[x] = packPixel(r, g, b);
+				return;
+			}
+			int index = (y * pitch) + (x * 3);
 			image[index] = r;
 			image[index + 1] = g;
 			image[index + 2] = b;
@@ -495,6 +549,11 @@ namespace GamesEngineeringBase
 		// Draws a pixel at the specified pixel index with the given RGB color
 		void draw(int pixelIndex, unsigned char r, unsigned char g, unsigned char b)
 		{
+			if (bytesPerPixel == 4)
+			{
+				draw(pixelIndex % width, pixelIndex / width, r, g, b);
+				return;
+			}
 			int index = pixelIndex * 3;
 			image[index] = r;
 			image[index + 1] = g;
@@ -504,7 +563,12 @@ namespace GamesEngineeringBase
 		// Draws a pixel at (x, y) using the color from the provided pixel array
 		void draw(int x, int y, unsigned char* pixel)
 		{
-			int index = ((y * width) + x) * 3;
+			if (bytesPerPixel == 4)
+			{
+				reinterpret_cast<unsigned int*>(image + (y * pitch))[x] = packPixel(pixel[0], pixel[1], pixel[2]);
+				return;
+			}
+			int index = (y * pitch) + (x * 3);
 			image[index] = pixel[0];
 			image[index + 1] = pixel[1];
 			image[index + 2] = pixel[2];
@@ -513,7 +577,38 @@ namespace GamesEngineeringBase
 		// Clears the back buffer by setting all pixels to black
 		void clear()
 		{
-			memset(image, 0, width * height * 3 * sizeof(unsigned char));
+			memset(image, 0, pitch * height * sizeof(unsigned char));
+		}
+
+		// Returns the layout of the back buffer
+		PixelFormat getPixelFormat() const
+		{
+			return (bytesPerPixel == 4) ? PixelRGBX32 : PixelRGB24;
+		}
+
+		// Returns the number of bytes used by one pixel (3 or 4)
+		unsigned int getBytesPerPixel() const
+		{
+			return bytesPerPixel;
+		}
+
+		// Returns the number of bytes between the start of two rows of the back buffer
+		unsigned int getPitch() const
+		{
+			return pitch;
+		}
+
+		// Returns a pointer to the first pixel of row y
+		// There are no checks done on this so y should be within bounds
+		unsigned char* getRow(int y) const
+		{
+			return image + (y * pitch);
+		}
+
+		// Returns row y as 32-bit pixels, only valid for PixelRGBX32
+		unsigned int* getRow32(int y) const
+		{
+			return reinterpret_cast<unsigned int*>(image + (y * pitch));
 		}
 
 		// Presents the back buffer to the screen
@@ -536,6 +631,34 @@ namespace GamesEngineeringBase
 			pumpLoop();
 		}
 
+		// Presents the back buffer but only uploads rows firstRow to lastRow - 1, the rest of the GPU copy is kept from earlier frames
+		// Useful when only a part of the image changed since the last present
+		void present(unsigned int firstRow, unsigned int lastRow)
+		{
+			if (lastRow > height)
+			{
+				lastRow = height;
+			}
+			if (firstRow < lastRow)
+			{
+				// Buffer boxes are in bytes, keep them on 4 byte boundaries like the rest of the buffer
+				D3D11_BOX box = {};
+				box.left = (firstRow * pitch) & ~3u;
+				box.right = min(((lastRow * pitch) + 3) & ~3u, paddedDataSize);
+				box.top = 0;
+				box.bottom = 1;
+				box.front = 0;
+				box.back = 1;
+				devcontext->UpdateSubresource(buffer, 0, &box, image + box.left, paddedDataSize, 0);
+			}
+
+			float ClearColor[4] = { 0.0f, 0.0f, 1.0f, 1.0f }; // RGBA
+			devcontext->ClearRenderTargetView(rtv, ClearColor);
+			devcontext->Draw(3, 0);
+			sc->Present(0, 0);
+			pumpLoop();
+		}
+
 		// Returns the window's width
 		unsigned int getWidth() const
 		{
@@ -643,6 +766,7 @@ namespace GamesEngineeringBase
 			sc->Release();
 			devcontext->Release();
 			dev->Release();
+			_aligned_free(image);
 			CoUninitialize();
 		}
 	};
@@ -1,10 +1,9 @@
 #include "Hero.h"
 #include "Manager.h"
-#include "Enemies.h"  
 #include "World.h"
 
 // the update function of hero
-void Hero::update(GamesEngineeringBase::Window& canvas, float dt, World& world, Manager& manager, Camera& camera, bool isInfinite) {
+void Hero::update(const InputState& input, float dt, World& world, Manager& manager, Camera& camera, bool isInfinite) {
     isMoving = false; // we set is moving to false as at first it is standing without our input
     animTimer += dt;
     if (animTimer > 0.15f) { // in every 0.15 seconds the frame changes so it creates an animation
@@ -20,7 +19,7 @@ void Hero::update(GamesEngineeringBase::Window& canvas, float dt, World& world,
     const int MAP_HEIGHT_IN_TILES = WORLD_HEIGHT / 32; // 1344 / 32 = 42
 
     //so we check the next tile and if it is water it stops moving
-    if (canvas.keyPressed('W')) {
+    if (input.keyPressed('W')) {
         float tryY = y - speed * dt; // we try to guess the next y coord by adding the speed of the hero which gets multiplied by time to find the next y
         float centerX = x + frameWidth / 2; // center x of the hero for more accurate collision check
         float centerY = tryY + frameHeight / 2; 
@@ -45,7 +44,7 @@ void Hero::update(GamesEngineeringBase::Window& canvas, float dt, World& world,
             nextY = tryY;
         isMoving = true;
     }
-    if (canvas.keyPressed('S')) {
+    if (input.keyPressed('S')) {
         float tryY = y + speed * dt; 
         float centerX = x + frameWidth / 2; 
         float centerY = tryY + frameHeight * 0.85f; // heros feet are slightly below center so we use 0.85 to check bottom alignment
@@ -73,7 +72,7 @@ void Hero::update(GamesEngineeringBase::Window& canvas, float dt, World& world,
         isMoving = true; // used for walk animation
     }
 
-    if (canvas.keyPressed('A')) {
+    if (input.keyPressed('A')) {
         float tryX = x - speed * dt; // moving left
         float centerX = tryX + frameWidth / 2;
         float centerY = y + frameHeight / 2;
@@ -100,7 +99,7 @@ void Hero::update(GamesEngineeringBase::Window& canvas, float dt, World& world,
         isMoving = true;
     }
 
-    if (canvas.keyPressed('D')) {
+    if (input.keyPressed('D')) {
         float tryX = x + speed * dt; // moving right
         float centerX = tryX + frameWidth / 2;
         float centerY = y + frameHeight / 2;
@@ -128,7 +127,7 @@ void Hero::update(GamesEngineeringBase::Window& canvas, float dt, World& world,
     }
 
     // when we press space button it activates the area attack and it has to be not in cooldown
-    if (canvas.keyPressed(' ') && areaAttackTimer >= areaAttackCooldown) {
+    if (input.keyPressed(' ') && areaAttackTimer >= areaAttackCooldown) {
         manager.applyTopNHealthDamage(200.0f, *this); // we give 200 damage for each in area damage
         showAOE = true;
         areaAttackTimer = 0.0f;
@@ -143,10 +142,12 @@ void Hero::update(GamesEngineeringBase::Window& canvas, float dt, World& world,
     }
     
     // pressing the button F activates the power up
-    if (canvas.keyPressed('F') && !powerUp && !powerUpOnCooldown) {
+    if (input.keyPressed('F') && !powerUp && !powerUpOnCooldown) {
         powerUp = true;
         powerUpTimer = 0.0f;
-        cout << "Power Up ACTIVATED" << endl;
+        if (logEvents) {
+            cout << "Power Up ACTIVATED" << endl;
+        }
     }
 
     x = nextX;
@@ -166,7 +167,9 @@ void Hero::update(GamesEngineeringBase::Window& canvas, float dt, World& world,
         powerUpCooldownTimer += dt;
         if (powerUpCooldownTimer >= powerUpCooldown) {
             powerUpOnCooldown = false;
-            cout << "Power Up RECHARGED" << endl;
+            if (logEvents) {
+                cout << "Power Up RECHARGED" << endl;
+            }
         }
     }
 
@@ -174,13 +177,13 @@ void Hero::update(GamesEngineeringBase::Window& canvas, float dt, World& world,
     linearAttackTimer += dt;
     if (powerUp == false) {
         if (linearAttackTimer >= linearAttackCooldown) {
-            Enemy* target = manager.getClosestEnemy(x, y, linearAttackRange); // the target is the closest enemy to hero
-            if (target) {
+            int target = manager.getClosestEnemy(x, y, linearAttackRange); // the target is the closest enemy to hero
+            if (target >= 0) {
                 float heroCenterX = x + (frameWidth / 2.0f);
                 float heroCenterY = y + (frameHeight / 2.0f);
 
-                float enemyCenterX = target->getX() + 16.0f;
-                float enemyCenterY = target->getY() + 16.0f;
+                float enemyCenterX = manager.getEnemyX(target) + 16.0f;
+                float enemyCenterY = manager.getEnemyY(target) + 16.0f;
                 // we again get the locations of the hero and enemy to calculate the distance in spawn projectile later
                 manager.spawnProjectile(heroCenterX, heroCenterY, enemyCenterX, enemyCenterY, linearDamage, true); // we spawn projectiles and indicate that they come from the hero
 
@@ -190,13 +193,13 @@ void Hero::update(GamesEngineeringBase::Window& canvas, float dt, World& world,
     }
     else {
         if (linearAttackTimer >= linearAttackCooldown / 1.5) { // if power up is active hero shoots faster
-            Enemy* target = manager.getClosestEnemy(x, y, linearAttackRange);
-            if (target) {
+            int target = manager.getClosestEnemy(x, y, linearAttackRange);
+            if (target >= 0) {
                 float heroCenterX = x + (frameWidth / 2.0f);
                 float heroCenterY = y + (frameHeight / 2.0f);
 
-                float enemyCenterX = target->getX() + 16.0f;
-                float enemyCenterY = target->getY() + 16.0f;
+                float enemyCenterX = manager.getEnemyX(target) + 16.0f;
+                float enemyCenterY = manager.getEnemyY(target) + 16.0f;
 
                 manager.spawnProjectile(heroCenterX, heroCenterY, enemyCenterX, enemyCenterY, linearDamage, true); // we spawn projectiles and indicate that they come from the hero
 
@@ -209,13 +212,6 @@ void Hero::update(GamesEngineeringBase::Window& canvas, float dt, World& world,
         areaAttackTimer += dt;
     }
 
-    // it points to the right animation
-    if (isMoving == true) {
-        currentImage = &walkingImage;
-    }
-    else {
-        currentImage = &idleImage;
-    }
     //boundary controll
     if (!isInfinite) {
         // we check only if the world is finite
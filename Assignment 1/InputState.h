@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+using namespace std;
+
+// the escape key, the same code as VK_ESCAPE of the window. letters and space are their own characters
+const int KeyEscape = 0x1B;
+
+// The keys the game reacts to in one tick. The hero and the game loop used to ask the window directly, so the only
+// way to drive the game was a real keyboard. Now the window fills an InputState once per tick (or a replay does)
+// and everything else only reads the InputState. It doesn't include the window header, so the replay files can be
+// read without it.
+class InputState {
+    uint16_t keys = 0; // one bit for every key in keyList
+
+public:
+    // every key has its bit at its position in this list, the replay files depend on the order so only add to the end
+    static const int keyCount = 9;
+    static int keyAt(int bit) {
+        static const int keyList[keyCount] = { 'W', 'A', 'S', 'D', ' ', 'F', 'K', KeyEscape, 'N' };
+        return keyList[bit];
+    }
+
+    static InputState fromBits(uint16_t bits) {
+        InputState input;
+        input.keys = bits;
+        return input;
+    }
+
+    uint16_t getBits() const {
+        return keys;
+    }
+
+    void setKey(int key, bool down) {
+        for (int bit = 0; bit < keyCount; bit++) {
+            if (keyAt(bit) == key) {
+                if (down) {
+                    keys |= (uint16_t)(1u << bit);
+                }
+                else {
+                    keys &= (uint16_t)~(1u << bit);
+                }
+            }
+        }
+    }
+
+    // same as Window::keyPressed, a key that isn't in the list is never down
+    bool keyPressed(int key) const {
+        for (int bit = 0; bit < keyCount; bit++) {
+            if (keyAt(bit) == key) {
+                return (keys >> bit) & 1;
+            }
+        }
+        return false;
+    }
+};
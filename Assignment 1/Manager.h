@@ -1,8 +1,21 @@
 #pragma once
-#include "GamesEngineeringBase.h"
 #include "Enemies.h"
 #include "Camera.h"
 #include "Hero.h"
+#include "Projectiles.h"
+#include "Entities.h"
+#include "SpatialGrid.h"
+#include "WaveDirector.h"
+#include "Random.h"
+#include "SaveGame.h"
+#include "SaveWriter.h"
+#include "Autosave.h"
+#include "MappedFile.h"
+#include "SaveCompression.h"
+#include <memory>
+#include <sstream>
+#include <algorithm>
+#include <vector>
 #include <iostream>
 #include <fstream>
 using namespace std;
@@ -10,842 +23,500 @@ using namespace std;
 const int WORLD_Width = 1344;
 const int WORLD_Height = 1344;
 
-const unsigned int maxSize = 1000;
-
-class Projectile {
-    float x, y;
-    float dx, dy;
-    float speed;
-    float damage;
-    bool active;
-    bool isFromHero;
-
-public:
-    Projectile() { 
-        active = false; 
-    } // at first, the projectile is not active because it's not fired yet
-
-    void launch(float _x, float _y, float tx, float ty, float dmg, bool FromHero) { // x and y are the spawn points and tx and ty are target points
-        x = _x; y = _y; damage = dmg; speed = 100.0f; active = true; isFromHero = FromHero;
-        // this sets up the projectile when fired: start point, direction, and damage
-        float vx = tx - x;
-        float vy = ty - y;
-        float len = sqrt(vx * vx + vy * vy);
-        if (len > 0.001f) {
-            dx = vx / len;
-            dy = vy / len;
-            // dividing by length normalizes the direction vector (gives unit direction)
-        }
-        else {
-            dx = 0; dy = 0;
-            // if hero and target are too close, we prevent division by zero
-        }
+class Manager {
+    vector<EnemyType> enemyTypes; // what is the same for every enemy of a type, the enemies store an index into it
+    EnemyArchetype enemies; // every enemy as columns of components
+    ProjectileArchetype projectiles; // only the live projectiles
+    SpatialGrid enemyGrid; // every enemy by position, built again every update once the dead ones are removed
+    vector<int> areaTargets; // reused by applyTopNHealthDamage()
+    vector<unsigned int> contactHits; // how many enemies of every type touch the hero in this frame
+    vector<unsigned int> contactTotals; // and in the whole level, the fps log shows them instead of printing every hit
+    vector<float> separationX, separationY; // the push of every enemy away from its neighbours, reused every frame
+
+    // the current spawn interval of every enemy type, the starting values are set in reset()
+    vector<float> spawnThreshold;
+    WaveDirector waves; // decides how many enemies spawn in a frame
+    vector<float> spawnRates; // reused every frame for the director
+    vector<unsigned int> spawnCounts;
+    vector<float> batchX, batchY; // the positions of the enemies spawned together
+    vector<unsigned int> fireList; // the enemies that shoot in this frame
+    vector<float> fireX, fireY, fireDamage; // and where their projectiles start
+    unsigned int maxProjectiles = 30000; // there is a huge limit that we won't reach
+    Random spawnRandom; // the spawn sides and positions, its own stream of the session's random numbers
+    uint64_t sessionSeed = 0; // written to the save so the run can be repeated
+    SaveWriter saveWriter; // writes the save files on its own thread
+    Autosave autosave{ saveWriter }; // the checkpoints and the journal
+    SaveCodec saveCodec = CodecFast; // how the save files are packed
+    bool logEvents = true; // the kills are printed, the headless simulation turns it off
+    float spawnIntervalScale = 1.0f; // multiplies the spawn intervals of the types, for balancing
+    unsigned int simulationTick = 0; // counts the updates, the level of detail uses it to spread the enemy updates
+
+    // Spawning and boundary control for every enemy type happens here.
+    // It ensures enemies appear just outside of camera view, then move toward the hero.
+    // all count enemies are added to the columns in one go
+    void spawnEnemies(unsigned int t, unsigned int count, Camera& camera, bool isInfinite) {
+        const EnemyType& type = enemyTypes[t];
+        unsigned int alive = enemies.sizeOfType(t);
+        if (alive >= type.maxAlive) {
+            return;
+        }
+        count = min(count, type.maxAlive - alive);
+        batchX.resize(count);
+        batchY.resize(count);
+        for (unsigned int i = 0; i < count; i++) {
+            spawnPosition(type, camera, isInfinite, batchX[i], batchY[i]);
+            spawnThreshold[t] = max(type.spawnIntervalMin, spawnThreshold[t] - type.spawnIntervalStep); // reduce threshold over time to increase spawn rate
+        }
+        enemies.spawnBatch((unsigned char)t, count, batchX.data(), batchY.data(), type.health);
     }
 
-    void update(float dt, bool isInfinite) {
-        if (!active) {
-            return; // if projectile isn't active we skip updating
-        }
-        x += dx * speed * dt;
-        y += dy * speed * dt;
-        // position changes over time according to direction (dx,dy) and speed
+    // every enemy in the fire list shoots at the hero's center, the projectiles are allocated together
+    void fireEnemyProjectiles(Hero& hero) {
+        unsigned int n = (unsigned int)fireList.size();
+        if (n == 0) {
+            return;
+        }
+        fireX.resize(n);
+        fireY.resize(n);
+        fireDamage.resize(n);
+        for (unsigned int k = 0; k < n; k++) {
+            unsigned int i = fireList[k];
+            fireX[k] = enemies.x[i] + 16.0f;
+            fireY[k] = enemies.y[i] + 22.0f;
+            fireDamage[k] = enemyTypes[enemies.type[i]].projectileDamage;
+        }
+        // the last parameter false means the projectiles belong to the enemies
+        projectiles.launchBatch(n, fireX.data(), fireY.data(), fireDamage.data(), hero.getX() + 16.0f, hero.getY() + 22.0f, false);
+    }
 
+    // a random position just outside of the view
+    void spawnPosition(const EnemyType& type, Camera& camera, bool isInfinite, float& outX, float& outY) {
+        float camX = camera.getX();
+        float camY = camera.getY();
+        int viewW = camera.getViewWidth();
+        int viewH = camera.getViewHeight();
+        float margin = type.spawnMargin;
+        float spawnX = 0.0f;
+        float spawnY = 0.0f;
+
+        int side = (int)spawnRandom.below(4); // 0: top, 1: bottom, 2: left, 3: right to spawn them randomly at the every side of the map
+        // this creates a more dynamic world feel since enemies appear from any side
+        switch (side) {
+        case 0: // top
+            spawnX = camX + (int)spawnRandom.below(viewW); // it spawns in the width of the view randomly but above of the camera
+            spawnY = camY - margin;
+            break;
+        case 1: // bottom
+            spawnX = camX + (int)spawnRandom.below(viewW);
+            spawnY = camY + viewH + margin;
+            break;
+        case 2: // left
+            spawnX = camX - margin;
+            spawnY = camY + (int)spawnRandom.below(viewH); // any height of the view
+            break;
+        case 3: // right
+            spawnX = camX + viewW + margin;
+            spawnY = camY + (int)spawnRandom.below(viewH);
+            break;
+        }
+        // boundary check
         if (!isInfinite) {
-            if (x < 0 || y < 0 || x > 1344 || y > 1344) // if it is out of bounds
-                active = false;
-            // if the world is finite and projectile leaves boundaries, we deactivate it
-        }
-    }
-
-    void draw(GamesEngineeringBase::Window& canvas, Camera& camera) {
-        if (active) {
-            float camX = camera.getX();
-            float camY = camera.getY();
-            int radius = 3;
-            int r2 = radius * radius;
-            // we draw small circles for each projectile to visualize them easily
-            for (int dy = -radius; dy <= radius; dy++) { // it makes it from -3 to 3 which makes it a circle
-                for (int dx = -radius; dx <= radius; dx++) {
-                    if (dx * dx + dy * dy <= r2) {
-                        int px = (int)(x - camX) + dx;
-                        int py = (int)(y - camY) + dy;
-                        if (px >= 0 && py >= 0 && px < (int)canvas.getWidth() && py < (int)canvas.getHeight())
-                            if (isFromHero == true) {
-                                canvas.draw(px, py, 0, 0, 255); // hero projectiles are blue
-                            }
-                            else {
-                                canvas.draw(px, py, 255, 0, 0); // enemy projectiles are red
-                            }
-                    }
-                }
-            }
-        }
+            // if the world is finite, clamp enemy positions to valid map coordinates
+            if (spawnX < 0) spawnX = 0;
+            if (spawnY < 0) spawnY = 0;
+            if (spawnX > WORLD_Width - 32)
+                spawnX = WORLD_Width - 32;
+            if (spawnY > WORLD_Height - 32)
+                spawnY = WORLD_Height - 32;
+        }
+        outX = spawnX;
+        outY = spawnY;
     }
 
-    bool collide(float ex_center, float ey_center) {
-        if (!active)
-            return false;
-
-        float dx = x - ex_center;
-        float dy = y - ey_center;
-        float distanceSquared = (dx * dx) + (dy * dy);
-        // we calculate the squared distance between projectile and target
-
-        float bulletRadius = 3.0f;
-        float enemyRadius = 8.0f;
-        float combinedRadius = bulletRadius + enemyRadius;
-        float combinedRadiusSquared = combinedRadius * combinedRadius;
-
-        return distanceSquared < combinedRadiusSquared;
-        // if the distance is smaller than combined radii that means collision happened
+    // puts every enemy in the grid, the id is the index in the enemy columns
+    void rebuildEnemyGrid() {
+        enemyGrid.clear();
+        for (unsigned int i = 0; i < enemies.size(); i++) {
+            enemyGrid.insert(i, enemies.x[i], enemies.y[i]);
+        }
+        enemyGrid.build();
     }
 
-    float getDamage() {
-        return damage; // returns how much damage projectile will deal
-    }
-    bool isActive() {
-        return active; // checks if the projectile is still alive/visible
-    }
-    void deactivate() {
-        active = false;  // when projectile hits something or goes out, deactivate it
-    }
-    bool getIsFromHero() {
-        return isFromHero; // true = hero projectile, false = enemy projectile
-    }
-    void saveState(ofstream& file) {
-        file << active;
-        if (active) {
-            file << " " << x << " " << y << " " << dx << " " << dy << " " << damage << " " << isFromHero;
+    // the contact damage system, touching an enemy hurts both the hero and the enemy.
+    // only the enemies the grid has around the hero are tested, so the cost doesn't grow with the population. the
+    // touches are counted per type and the hero gets the damage of every type in one step
+    void contactDamage(Hero& hero) {
+        float heroX, heroY, heroRadius;
+        hero.getHitCircle(heroX, heroY, heroRadius);
+        const float combined = heroRadius + 8.0f; // the enemy radius is 8
+        const float combinedSquared = combined * combined;
+        for (unsigned int t = 0; t < contactHits.size(); t++) {
+            contactHits[t] = 0;
+        }
+
+        // the grid has the top left corners of the enemies, the centers are at +16, +22
+        enemyGrid.forEachInRect(heroX - 16.0f - combined, heroY - 22.0f - combined, heroX - 16.0f + combined, heroY - 22.0f + combined,
+            [&](int i, float ex, float ey) {
+                float dx = ex + 16.0f - heroX;
+                float dy = ey + 22.0f - heroY;
+                if (dx * dx + dy * dy < combinedSquared) {
+                    unsigned char t = enemies.type[i];
+                    enemies.damage(i, enemyTypes[t].contactSelfDamage);
+                    contactHits[t]++;
+                }
+            });
+
+        for (unsigned int t = 0; t < contactHits.size(); t++) {
+            if (contactHits[t] == 0) {
+                continue;
+            }
+            const EnemyType& type = enemyTypes[t];
+            hero.getDamage(type.contactDamage * contactHits[t]);
+            contactTotals[t] += contactHits[t];
         }
-        file << "\n";
-        // this allows all active projectiles to be saved and restored later (for save/load)
     }
 
-    void loadState(ifstream& file) {
-        file >> active;
-        if (active) {
-            file >> x >> y >> dx >> dy >> damage >> isFromHero;
+    // removes the dead enemies and rewards the hero with the score of their type
+    void removeDeadEnemies(Hero& hero) {
+        for (unsigned int i = 0; i < enemies.size(); ) { // loop through all enemies manually
+            if (enemies.isDead(i)) {
+                const EnemyType& type = enemyTypes[enemies.type[i]];
+                hero.updateScore(type.score); // reward the hero for killing it
+                if (logEvents) {
+                    cout << "Destroyed " << type.name << ": " << i << endl; // debug info printed to console
+                }
+                enemies.remove(i); // the last enemy moves into this slot so we check i again
+            }
+            else i++;  // only move to next enemy if no deletion happened
         }
-        // when loading, we restore each projectiles active state and parameters
     }
-};
 
-class Manager {
-    Goblin* garray[maxSize]; //to create random goblins
-    HeavyGoblin* hgarray[maxSize]; //to create random heavy goblins
-    Slime* sarray[maxSize]; //to create random slimes
-    Musketeer* marray[maxSize]; // to create random musketeers
-    Projectile* projectiles; // to point at projectiles
-
-    // All spawn timers and cooldowns to control frequency of enemy creation
-    float goblinTimer = 0.0f;
-    float heavyTimer = 0.0f;
-    float slimeTimer = 0.0f;
-    float MusketeerTimer = 0.0f;
-    float goblinThreshold = 4.f; // goblin spawns most and it has the lowest threshold
-    float heavyThreshold = 7.f; // heavy goblins spawn least as they are harder to kill
-    float slimeThreshold = 6.f; // slimes are fast so they dont spawn much
-    float MusketeerThreshold = 6.f; // as they don't move they spawn same as slimes
-    unsigned int goblinSize = 0; // they have their own capacities and limits to be spawned correctly
-    unsigned int heavyGoblinSize = 0;
-    unsigned int slimeSize = 0;
-    unsigned int musketeerSize = 0;
-    int maxProjectiles = 30000; // there is a huge limit that we won't reach
-
-    // Spawning and boundary control for all enemy types happen in these four private functions.
-    // Each function ensures enemies appear just outside of camera view, then move toward the hero.
-
-    void createGoblin(GamesEngineeringBase::Window& canvas, Camera& camera, bool isInfinite) {
-        float camX = camera.getX();
-        float camY = camera.getY();
-        float viewW = 1024;
-        float viewH = 768;
-        if (goblinSize < maxSize && goblinTimer > goblinThreshold) {
-            float goblinX;
-            float goblinY;
-            int goblinSide = rand() % 4; // 0: top, 1: bottom, 2: left, 3: right to spawn them randomly at the every side of the map
-            // this creates a more dynamic world feel since enemies appear from any side
-            switch (goblinSide) {
-            case 0: // top
-                goblinX = camX + (rand() % (int)viewW); // goblim spawms in the width of the area randomly but also it is above of the camera
-                goblinY = camY - 32; // goblin spawns right above of the view
-                break;
-            case 1: // bottom
-                goblinX = camX + (rand() % (int)viewW); // x is still random in the map
-                goblinY = camY + viewH + 32; //it is at the bottom of the map
-                break;
-            case 2: // left
-                goblinX = camX - 32; // it spawns at the left not seen in the camera
-                goblinY = camY + (rand() % (int)viewH); // any height on the world
-                break;
-            case 3: // right
-                goblinX = camX + viewW + 32; // it spawns at the right not seen in the camera
-                goblinY = camY + (rand() % (int)viewH); // any height on the world
-                break;
-            }
-            // boundary check
-            if (!isInfinite) {
-                // if the world is finite, clamp enemy positions to valid map coordinates
-                if (goblinX < 0) goblinX = 0;
-                if (goblinY < 0) goblinY = 0;
-                if (goblinX > WORLD_Width - 32) 
-                    goblinX = WORLD_Width - 32;
-                if (goblinY > WORLD_Height - 32) 
-                    goblinY = WORLD_Height - 32;
-            }
-            garray[goblinSize] = new Goblin(goblinX, goblinY, "Resources/Goblin - Idle.png", "Resources/Goblin - Walk.png");
-            // we create a new goblin instance with idle and walk sprites
-            goblinSize++;
-            goblinTimer = 0.f; // reset timer after each spawn
-            goblinThreshold = max(0.5f, goblinThreshold - 0.2f); // reduce threshold over time to increase spawn rate
-        }
-    }
-
-    void createHeavyGoblin(GamesEngineeringBase::Window& canvas, Camera& camera, bool isInfinite) {
-        if (heavyGoblinSize < maxSize && heavyTimer > heavyThreshold) {
-            float camX = camera.getX();
-            float camY = camera.getY();
-            float heavyGoblinX;
-            float heavyGoblinY;
-            float viewW = 1024;
-            float viewH = 768;
-            int HeavyGoblinSide = rand() % 4; // 0: top, 1: bottom, 2: left, 3: right to spawn them randomly at the every side of the map
-            switch (HeavyGoblinSide) {
-            case 0: // top
-                heavyGoblinX = camX + (rand() % (int)viewW); // heavy goblim spawms in the width of the area randomly but also it is above of the camera
-                heavyGoblinY = camY - 32; // goblin spawns right above of the view
-                break;
-            case 1: // bottom
-                heavyGoblinX = camX + (rand() % (int)viewW); // x is still random in the map
-                heavyGoblinY = camY + viewH + 32; //it is at the bottom of the map
-                break;
-            case 2: // left
-                heavyGoblinX = camX - 32; // it spawns at the left not seen in the camera
-                heavyGoblinY = camY + (rand() % (int)viewH); // any height on the world
-                break;
-            case 3: // right
-                heavyGoblinX = camX + viewW + 32; // it spawns at the right not seen in the camera
-                heavyGoblinY = camY + (rand() % (int)viewH); // any height on the world
-                break;
-            }
-            if (!isInfinite) {
-                if (heavyGoblinX < 0)
-                    heavyGoblinX = 0;
-                if (heavyGoblinY < 0)
-                    heavyGoblinY = 0;
-                if (heavyGoblinX > WORLD_Width - 32)
-                    heavyGoblinX = WORLD_Width - 32;
-                if (heavyGoblinY > WORLD_Height - 32)
-                    heavyGoblinY = WORLD_Height - 32;
-            }
-            hgarray[heavyGoblinSize] = new HeavyGoblin(heavyGoblinX, heavyGoblinY, "Resources/H_Goblin - Idle.png", "Resources/H_Goblin - Walk.png");
-            heavyGoblinSize++;
-            heavyTimer = 0.f;
-            heavyThreshold = max(0.5f, heavyThreshold - 0.2f);
-        }
-    }
-
-    void createSlime(GamesEngineeringBase::Window& canvas, Camera& camera, bool isInfinite) {
-        if (slimeSize < maxSize && slimeTimer > slimeThreshold) {
-            float camX = camera.getX();
-            float camY = camera.getY();
-            float slimeX;
-            float slimeY;
-            float viewW = 1024;
-            float viewH = 768;
-            float randX = static_cast<float>(rand() % (canvas.getWidth() - 32));
-            float randY = static_cast<float>(rand() % (canvas.getHeight() / 3));
-            int slimeSide = rand() % 4; // 0: top, 1: bottom, 2: left, 3: right to spawn them randomly at the every side of the map
-            switch (slimeSide) {
-            case 0: // top
-                slimeX = camX + (rand() % (int)viewW); // slime spawms in the width of the area randomly but also it is above of the camera
-                slimeY = camY - 32; // slime spawns right above of the view
-                break;
-            case 1: // bottom
-                slimeX = camX + (rand() % (int)viewW); // x is still random in the map
-                slimeY = camY + viewH + 32; //it is at the bottom of the map
-                break;
-            case 2: // left
-                slimeX = camX - 32; // it spawns at the left not seen in the camera
-                slimeY = camY + (rand() % (int)viewH); // any height on the world
-                break;
-            case 3: // right
-                slimeX = camX + viewW + 32; // it spawns at the right not seen in the camera
-                slimeY = camY + (rand() % (int)viewH); // any height on the world
-                break;
-            }
-            if (!isInfinite) {
-                if (slimeX < 0)
-                    slimeX = 0;
-                if (slimeY < 0)
-                    slimeY = 0;
-                if (slimeX > WORLD_Width - 32)
-                    slimeX = WORLD_Width - 32;
-                if (slimeY > WORLD_Height - 32)
-                    slimeY = WORLD_Height - 32;
+    // the projectile collision system, hero projectiles hit enemies and enemy projectiles hit the hero.
+    // only checking where a projectile ends up let it fly through an enemy when a frame took long (and the levels make
+    // dt even bigger), so the whole way it moved in this tick is checked. the enemy grid gives the enemies near the way
+    // and the one it touches first is hit
+    void projectileHits(Hero& hero) {
+        // if bullet is coming from the enemies it should hit the hero
+        float heroCenterX = hero.getX() + 16.0f;
+        float heroCenterY = hero.getY() + 22.0f;
+        const float hitRadius = ProjectileArchetype::radius + 8.0f; // the bullet radius plus the enemy radius
+        const float step = projectiles.getLastStep();
+
+        for (unsigned int i = 0; i < projectiles.size(); ) {
+            bool hit = false;
+            float moveX = projectiles.dx[i] * step;
+            float moveY = projectiles.dy[i] * step;
+            float startX = projectiles.x[i] - moveX;
+            float startY = projectiles.y[i] - moveY;
+            if (projectiles.fromHero[i]) {
+                // if the bullet is coming from the hero we gotta shoot the enemies
+                // the grid has the top left corners of the enemies, the centers are at +16, +22
+                float x0 = min(startX, projectiles.x[i]) - 16.0f - hitRadius;
+                float y0 = min(startY, projectiles.y[i]) - 22.0f - hitRadius;
+                float x1 = max(startX, projectiles.x[i]) - 16.0f + hitRadius;
+                float y1 = max(startY, projectiles.y[i]) - 22.0f + hitRadius;
+                int first = -1;
+                float firstTime = 2.0f;
+                enemyGrid.forEachInRect(x0, y0, x1, y1, [&](int j, float ex, float ey) {
+                    float t;
+                    if (sweptCircleHit(startX, startY, moveX, moveY, ex + 16.0f, ey + 22.0f, hitRadius, t) && (t < firstTime || (t == firstTime && j < first))) {
+                        first = j; // the same enemy wins no matter in which order the grid gives them
+                        firstTime = t;
+                    }
+                });
+                if (first >= 0) {
+                    enemies.damage(first, projectiles.damage[i]);
+                    hit = true; // the bullet hit
+                }
             }
-            sarray[slimeSize] = new Slime(slimeX, slimeY, "Resources/Slime - Idle.png", "Resources/Slime - Walk.png");
-            slimeSize++;
-            slimeTimer = 0.f;
-            slimeThreshold = max(0.5f, slimeThreshold - 0.2f);
-        }
-    }
-
-    void createMusketeer(GamesEngineeringBase::Window& canvas, Camera& camera, bool isInfinite) {
-        if (musketeerSize < maxSize && MusketeerTimer > MusketeerThreshold) { 
-
-            float camX = camera.getX();
-            float camY = camera.getY();
-            float viewW = 1024.0f;
-            float viewH = 768.0f;
-
-            float MusketeerX = 0.0f; 
-            float MusketeerY = 0.0f; 
-
-            const float SPAWN_MARGIN = 100.0f;
-
-            int side = rand() % 4;
-            switch (side) {
-            case 0: // top
-                MusketeerX = camX + (rand() % (int)viewW);
-                MusketeerY = camY - SPAWN_MARGIN;
-                break;
-            case 1: // bottom
-                MusketeerX = camX + (rand() % (int)viewW);
-                MusketeerY = camY + viewH + SPAWN_MARGIN;
-                break;
-            case 2: // left
-                MusketeerX = camX - SPAWN_MARGIN;
-                MusketeerY = camY + (rand() % (int)viewH);
-                break;
-            case 3: // right
-                MusketeerX = camX + viewW + SPAWN_MARGIN;
-                MusketeerY = camY + (rand() % (int)viewH);
-                break;
+            else {
+                float t;
+                if (sweptCircleHit(startX, startY, moveX, moveY, heroCenterX, heroCenterY, hitRadius, t)) {
+                    hero.getDamage(projectiles.damage[i]);
+                    hit = true;
+                }
             }
-
-            if (!isInfinite) {
-                if (MusketeerX < 0) 
-                    MusketeerX = 0;
-                if (MusketeerY < 0) 
-                    MusketeerY = 0;
-                if (MusketeerX > WORLD_Width - 32) 
-                    MusketeerX = WORLD_Width - 32;
-                if (MusketeerY > WORLD_Height - 32) 
-                    MusketeerY = WORLD_Height - 32;
+            if (hit) {
+                projectiles.remove(i); // the last projectile moved into i
             }
-
-            marray[musketeerSize] = new Musketeer(MusketeerX, MusketeerY, "Resources/Musketeer.png", 250);
-
-            if (!marray[musketeerSize]) {
-                return;
+            else {
+                i++;
             }
-
-            musketeerSize++;
-            MusketeerTimer = 0.f;
-            MusketeerThreshold = max(1.5f, MusketeerThreshold - 0.1f);
         }
     }
 
 public:
     Manager() {
-        //the constructor of the manager
-        for (unsigned int i = 0; i < maxSize; i++) {
-            garray[i] = nullptr;
-            hgarray[i] = nullptr;
-            sarray[i] = nullptr;
-            marray[i] = nullptr;
-        }
-        projectiles = new Projectile[maxProjectiles];
-        //it creates arrays for goblins, heavy goblins, slimes and musketeers. also it sets the projectile pointer to a new dynamic projectile array
+        //the constructor of the manager, the sprites of the enemy types are loaded by the ActorRenderer
+        if (!loadEnemyTypes("Resources/enemies.txt", enemyTypes)) {
+            loadDefaultEnemyTypes(enemyTypes); // we can still play with the built in types
+        }
+        waves.loadSettings("Resources/waves.txt");
+        enemies.reserve(waves.getSettings().maxEnemies); // the director never lets more than this be alive
+        spawnThreshold.resize(enemyTypes.size());
+        spawnRates.resize(enemyTypes.size());
+        contactHits.resize(enemyTypes.size());
+        contactTotals.resize(enemyTypes.size());
+        projectiles.setCapacity(maxProjectiles);
+        projectiles.loadSettings("Resources/projectiles.txt"); // it can change the capacity and what happens when it's full
+        fireList.reserve(waves.getSettings().maxEnemies);
+        separationX.reserve(waves.getSettings().maxEnemies);
+        separationY.reserve(waves.getSettings().maxEnemies);
+        reset();
     }
-    // the desturctor which deletes the created enemies and projectiles
-    ~Manager() {
-        for (unsigned int i = 0; i < goblinSize; i++) {
-            if (garray[i])
-                delete garray[i];
-        }
 
-        for (unsigned int i = 0; i < heavyGoblinSize; i++) {
-            if (hgarray[i])
-                delete hgarray[i];
-        }
+    // removes every enemy and projectile, the columns keep their memory
+    void clearEntities() {
+        enemies.clear();
+        projectiles.clear();
+        rebuildEnemyGrid(); // the grid must not point at the removed enemies
+    }
 
-        for (unsigned int i = 0; i < slimeSize; i++) {
-            if (sarray[i])
-                delete sarray[i];
-        }
-        for (unsigned int i = 0; i < musketeerSize; i++) { 
-            if (marray[i]) 
-                delete marray[i]; 
-        }
-        delete[] projectiles;
+    // prepares the manager for a new level. the game session keeps one manager for the whole run so the
+    // columns are not allocated again for every level
+    void reset(int level = 1) {
+        clearEntities();
+        fill(contactTotals.begin(), contactTotals.end(), 0);
+        for (unsigned int t = 0; t < enemyTypes.size(); t++) {
+            spawnThreshold[t] = enemyTypes[t].spawnInterval * spawnIntervalScale;
+        }
+        waves.reset((unsigned int)enemyTypes.size(), level); // also forgets the frame times of the last level
+        simulationTick = 0; // the level of detail spreads the enemies over the ticks the same way in every run of a level
+        autosave.invalidate(); // the old checkpoint belongs to the last level
     }
 
-    void update(GamesEngineeringBase::Window& canvas, float dt, Camera& camera, Hero& hero, bool isInfinite) {
-        goblinTimer += dt;
-        heavyTimer += dt;
-        slimeTimer += dt;
-        MusketeerTimer += dt;
+    void setLogEvents(bool enabled) {
+        logEvents = enabled;
+    }
 
-        if (goblinTimer > goblinThreshold) {
-            createGoblin(canvas, camera, isInfinite);
-            goblinTimer = 0.f;
-        }
+    // the saves and the autosave checkpoints from now on are packed with it
+    void setSaveCodec(SaveCodec codec) {
+        saveCodec = codec;
+        autosave.setCodec(codec);
+    }
 
-        if (heavyTimer > heavyThreshold) { // heavy goblins are created less and slower as they are harder to kill
-            createHeavyGoblin(canvas, camera, isInfinite);
-            heavyTimer = 0.f;
-        }
+    // takes effect from the next reset(), bigger than 1 means the enemies come slower
+    void setSpawnIntervalScale(float scale) {
+        spawnIntervalScale = (scale > 0.0f) ? scale : 1.0f;
+    }
 
-        if (slimeTimer > slimeThreshold) { // slimes are created more than heavy goblins but less than goblins
-            createSlime(canvas, camera, isInfinite);
-            slimeTimer = 0.f;
-        }
+    unsigned int getEnemyCount() const {
+        return enemies.size();
+    }
 
-        if (MusketeerTimer > MusketeerThreshold) { 
-            createMusketeer(canvas, camera,isInfinite); 
-            MusketeerTimer = 0.f; 
-        }
+    unsigned int getProjectileCount() const {
+        return projectiles.size();
+    }
 
-        for (unsigned int i = 0; i < goblinSize; i++) {
-            if (garray[i]) {
-                garray[i]->update(dt, 80.0f,hero, *this); // it moves faster than heavy goblin but slower than slime
-            }
-        }
+    // every try of a level gets its own spawn stream from the session seed, the level and the attempt (how many levels
+    // were started before it), so playing a level again doesn't spawn the same enemies but a seed and attempt always do
+    void seedRandom(const RandomService& random, int level, uint32_t attempt) {
+        sessionSeed = random.getSeed();
+        spawnRandom = random.stream(StreamSpawn, (uint32_t)level + (attempt << 16)); // there are fewer than 65536 levels
+    }
 
-        for (unsigned int i = 0; i < heavyGoblinSize; i++) {
-            if (hgarray[i]) {
-                hgarray[i]->update(dt,40.0f,hero, *this); // as it is heavier it moves slower
-            }
-        }
+    uint64_t getSessionSeed() const {
+        return sessionSeed;
+    }
 
-        for (unsigned int i = 0; i < slimeSize; i++) {
-            if (sarray[i]) {
-                sarray[i]->update(dt,100.0f,hero,*this); // as it is smaller it is the fastest
-            }
-        }
+    // the main loop tells how long the last frame really took, the director slows the spawns down if it's too long.
+    // it must not be called while a level is recorded or replayed, the replay doesn't have the frame times
+    void reportFrameTime(float seconds) {
+        waves.reportFrameTime(seconds);
+    }
 
-        for (unsigned int i = 0; i < musketeerSize; i++) {
-            if (marray[i]) { 
-                marray[i]->update(dt, 0.0f, hero, *this); //they don't move
-            }
+    // the update doesn't need the window, so the headless simulation can run it too
+    void update(float dt, Camera& camera, Hero& hero, bool isInfinite) {
+        // every type wants to spawn once per spawn interval, the director decides how much of that really happens
+        for (unsigned int t = 0; t < enemyTypes.size(); t++) {
+            spawnRates[t] = 1.0f / spawnThreshold[t];
         }
-
-        // Deletion of Goblins based on health
-      
-        for (unsigned int i = 0; i < goblinSize; ) { // loop through all goblins manually 
-            if (garray[i] && garray[i]->isDead()) {  // if this goblin exists and is dead
-                delete garray[i];  // we delete it
-                hero.updateScore(100);  // reward the hero with 100 points for killing a goblin
-                cout << "Destroyed Goblin: " << i << endl; // debug info printed to console
-
-                if (goblinSize > 1 && i != goblinSize - 1) // if there is more than one goblin and it's not the last one
-                    garray[i] = garray[goblinSize - 1]; // move the last goblin into the deleted goblins slot
-                else
-                    garray[i] = nullptr; // otherwise just set it to null if it was the last one
-
-                garray[goblinSize - 1] = nullptr; // clear the last slot (it was either deleted or moved)
-                goblinSize--; // reduce goblin count
-            }
-            else i++;  // only move to next goblin if no deletion happened
-            //the reason we use that aproach is that keeping the enemies in the memory caused too much stuttering as the game was going on
-        }
-
-        //same for others
-        // Heavy Goblins
-        for (unsigned int i = 0; i < heavyGoblinSize; ) {
-            if (hgarray[i] && hgarray[i]->isDead()) {
-                delete hgarray[i];
-                hero.updateScore(200);
-                cout << "Destroyed Heavy Goblin: " << i << endl;
-                if (heavyGoblinSize > 1 && i != heavyGoblinSize - 1)
-                    hgarray[i] = hgarray[heavyGoblinSize - 1];
-                else
-                    hgarray[i] = nullptr;
-                hgarray[heavyGoblinSize - 1] = nullptr;
-                heavyGoblinSize--;
-            }
-            else i++;
-        }
-
-        // Slimes
-        for (unsigned int i = 0; i < slimeSize; ) {
-            if (sarray[i] && sarray[i]->isDead()) {
-                delete sarray[i];
-                hero.updateScore(50);
-                cout << "Destroyed Slime: " << i << endl;
-                if (slimeSize > 1 && i != slimeSize - 1)
-                    sarray[i] = sarray[slimeSize - 1];
-                else
-                    sarray[i] = nullptr;
-                sarray[slimeSize - 1] = nullptr;
-                slimeSize--;
+        waves.plan(dt, spawnRates, enemies.size(), spawnCounts);
+        for (unsigned int t = 0; t < enemyTypes.size(); t++) {
+            if (spawnCounts[t] > 0) {
+                spawnEnemies(t, spawnCounts[t], camera, isInfinite);
             }
-            else i++;
-        }
-
-        for (unsigned int i = 0; i < musketeerSize; ) {
-            if (marray[i] && marray[i]->isDead()) {
-                delete marray[i];
-                hero.updateScore(250); 
-                cout << "Destroyed Musketeer: " << i << endl; 
-                if (musketeerSize > 1 && i != musketeerSize - 1)
-                    marray[i] = marray[musketeerSize - 1];
-                else
-                    marray[i] = nullptr;
-                marray[musketeerSize - 1] = nullptr;
-                musketeerSize--;
-            }
-            else i++;
         }
 
-        // the collision of the enemies and the hero
-        for (unsigned int i = 0; i < goblinSize; i++) {
-            if (garray[i] && hero.collide(garray[i]->getX(), garray[i]->getY())) {
-                hero.getDamage(10); // collision with a goblin gives 10 damage        
-                garray[i]->getDamage(20); // it gives them double the damage 
-                std::cout << "Goblin collided!" << endl;
-            }
-        }
+        // every system runs once over all the enemies no matter how many types there are
+        // far away enemies are simulated less often but for longer steps
+        simulationLevelOfDetail(enemies, dt, hero.getX(), hero.getY(), simulationTick++);
+        animateEnemies(enemies, enemyTypes);
+        enemyAttacks(enemies, enemyTypes, fireList);
+        fireEnemyProjectiles(hero);
+        // the grid is from the end of the last update, the enemies spawned since then are only missing as neighbours
+        separateEnemies(enemies, enemyTypes, enemyGrid, separationX, separationY);
+        moveEnemies(enemies, enemyTypes, hero.getX(), hero.getY(), separationX, separationY);
 
-        for (unsigned int i = 0; i < heavyGoblinSize; i++) {
-            if (hgarray[i] && hero.collide(hgarray[i]->getX(), hgarray[i]->getY())) {
-                hero.getDamage(20); // collision with a heavy goblin gives 20 damage              
-                hgarray[i]->getDamage(40); 
-                std::cout << "Heavy collided!" << endl;
-            }
-        }
+        //the reason we remove them right away is that keeping the enemies in the memory caused too much stuttering as the game was going on
+        removeDeadEnemies(hero);
 
-        for (unsigned int i = 0; i < slimeSize; i++) {
-            if (sarray[i] && hero.collide(sarray[i]->getX(), sarray[i]->getY())) {
-                hero.getDamage(5); // collision with a slime gives 5 damage    
-                sarray[i]->getDamage(10);
-                std::cout << "Slime collided!" << endl;
-            }
-        }
+        // the enemies are done moving and dying for this frame, the contacts and the projectiles use the grid to find them
+        rebuildEnemyGrid();
 
-        for (unsigned int i = 0; i < musketeerSize; i++) { 
-            if (marray[i] && hero.collide(marray[i]->getX(), marray[i]->getY())) { 
-                hero.getDamage(30); // collision with a musketeer gives 30 damage to hero
-                marray[i]->getDamage(60);
-                std::cout << "Musketeer collided!" << endl; 
-            }
-        }
+        // the collision of the enemies and the hero, it only hurts them so the grid stays right
+        contactDamage(hero);
 
         //Projectile System
-        for (unsigned int i = 0; i < maxProjectiles; i++) {
-            projectiles[i].update(dt, isInfinite);
-            if (!projectiles[i].isActive()) {
-                continue;
-            }
-            if (projectiles[i].getIsFromHero()) {
-                // if the bullet is coming from the hero we gotta shoot the enemies
-                for (unsigned int j = 0; j < goblinSize; j++) {
-                    if (garray[j] && projectiles[i].collide(garray[j]->getX() + 16, garray[j]->getY() + 22)) {
-                        garray[j]->getDamage(projectiles[i].getDamage());
-                        projectiles[i].deactivate();
-                        break; // the bullet hit
-                    }
-                }
-                if (projectiles[i].isActive()) { //for heavy goblins
-                    for (unsigned int j = 0; j < heavyGoblinSize; j++) {
-                        if (hgarray[j] && projectiles[i].collide(hgarray[j]->getX() + 16, hgarray[j]->getY() + 22)) {
-                            hgarray[j]->getDamage(projectiles[i].getDamage());
-                            projectiles[i].deactivate();
-                            break;
-                        }
-                    }
-                }
-                if (projectiles[i].isActive()) { // for slimes
-                    for (unsigned int j = 0; j < slimeSize; j++) {
-                        if (sarray[j] && projectiles[i].collide(sarray[j]->getX() + 16, sarray[j]->getY() + 22)) {
-                            sarray[j]->getDamage(projectiles[i].getDamage());
-                            projectiles[i].deactivate();
-                            break;
-                        }
-                    }
-                }
-                if (projectiles[i].isActive()) { 
-                    for (unsigned int j = 0; j < musketeerSize; j++) { 
-                        if (marray[j] && projectiles[i].collide(marray[j]->getX() + 16, marray[j]->getY() + 22)) { 
-                            marray[j]->getDamage(projectiles[i].getDamage()); 
-                            projectiles[i].deactivate();
-                            break;
-                        }
-                    }
-                }
-            }
-            else {
-                // if bullet is coming from the enemies it should hit the hero
-                float heroCenterX = hero.getX() + 16.0f;
-                float heroCenterY = hero.getY() + 22.0f; 
-
-                if (projectiles[i].collide(heroCenterX, heroCenterY)) {
-                    hero.getDamage(projectiles[i].getDamage());
-                    projectiles[i].deactivate();
-                }
-            }
-        }
+        projectiles.update(dt);
+        projectileHits(hero);
+        projectiles.removeOutOfWorld(isInfinite, WORLD_Width, WORLD_Height);
     }
 
-    void draw(GamesEngineeringBase::Window& canvas, Camera& camera) {
-        auto isInView = [&](float x, float y) {
-            return (x > camera.getX() - 64 && x < camera.getX()+ 1024 + 64 &&  y > camera.getY() - 64 && y < camera.getY() + 768 + 64);
-            };
-        // Goblins
-        for (unsigned int i = 0; i < goblinSize; i++) {
-            if (garray[i] && isInView(garray[i]->getX(), garray[i]->getY()))
-                garray[i]->draw(canvas, camera);
-        }
-
-        // Heavy Goblins
-        for (unsigned int i = 0; i < heavyGoblinSize; i++) {
-            if (hgarray[i] && isInView(hgarray[i]->getX(), hgarray[i]->getY()))
-                hgarray[i]->draw(canvas, camera);
-        }
-
-        // Slimes
-        for (unsigned int i = 0; i < slimeSize; i++) {
-            if (sarray[i] && isInView(sarray[i]->getX(), sarray[i]->getY()))
-                sarray[i]->draw(canvas, camera);
-        }
-        // Musketeers
-        for (unsigned int i = 0; i < musketeerSize; i++) {
-            if (marray[i] && isInView(marray[i]->getX(), marray[i]->getY()))
-                marray[i]->draw(canvas, camera);
-        }
-        for (unsigned int i = 0; i < maxProjectiles; i++) {
-            projectiles[i].draw(canvas, camera);
-        }
+    // the drawing side reads the game through these, the manager itself never draws
+    const vector<EnemyType>& getEnemyTypes() const {
+        return enemyTypes;
     }
 
-    void drawAOE(GamesEngineeringBase::Window& canvas, Camera& camera, float cx, float cy, float range) {// cx and cy are the center coordinates of the AOE
-        // range is the radius of the AOE circle
-
-        float camX = camera.getX();  // get current camera position for x and y 
-        float camY = camera.getY();  
-
-        int centerX = (int)(cx - camX);  // applying camera offset
-        int centerY = (int)(cy - camY);  // same for y
-
-        int r2outer = (int)(range * range);  // square of the AOE radius
-
-        float innerRange = range - 10.0f;      // we create a slightly smaller inner circle
-        int r2inner = (int)(innerRange * innerRange);  // its squared radius
-        // the goal is to draw only the ring area not a filled disc
-
-        // We loop through all pixels inside a square 
-        for (int y = -(int)range; y <= (int)range; y++) {
-            for (int x = -(int)range; x <= (int)range; x++) {
-
-                int dist_sq = x * x + y * y;  // compute squared distance from the center
-
-                // We draw only the pixels that fall inside the outer circle but outside the inner circle
-                if (dist_sq <= r2outer && dist_sq >= r2inner) {
-                    int px = centerX + x;  // convert local offset to screen X coordinate
-                    int py = centerY + y;  // convert local offset to screen Y coordinate
+    const EnemyArchetype& getEnemies() const {
+        return enemies;
+    }
 
-                    // ensure pixel is within the visible window boundaries before drawing
-                    if (px >= 0 && py >= 0 && px < (int)canvas.getWidth() && py < (int)canvas.getHeight())
-                        canvas.draw(px, py, 0, 0, 255); // draw blue pixels to represent AoE circle
-                }
-            }
-        }
+    const ProjectileArchetype& getProjectiles() const {
+        return projectiles;
     }
 
+    // every enemy by position, it is up to date after update()
+    const SpatialGrid& getEnemyGrid() const {
+        return enemyGrid;
+    }
 
-    Enemy* getClosestEnemy(float heroX, float heroY, float maxRange) {
-        Enemy* closestEnemy = nullptr; // stores the pointer to the nearest enemy found so far
+    // returns the index of the enemy closest to (heroX, heroY) within maxRange, or -1 if there is none
+    int getClosestEnemy(float heroX, float heroY, float maxRange) {
+        int closestEnemy = -1; // stores the index of the nearest enemy found so far
         float min_distance = maxRange;  // the maximum allowed distance to consider an enemy
 
-        // check Goblins
-        for (unsigned int i = 0; i < goblinSize; i++) {
-            if (garray[i]) { // we make sure that the goblin slot is not empty
-                float dx = heroX - garray[i]->getX(); // horizontal distance to hero
-                float dy = heroY - garray[i]->getY(); // vertical distance to hero
-                float distance = sqrt(dx * dx + dy * dy); // Euclidean distance as we use this everywhere
-                if (distance < min_distance) { // if this enemy is closer than the current closest one
-                    min_distance = distance; // update the minimum distance
-                    closestEnemy = garray[i]; // remember this enemy
-                }
-            }
-        }
-        // do the same for others
-        for (unsigned int i = 0; i < heavyGoblinSize; i++) {
-            if (hgarray[i]) {
-                float dx = heroX - hgarray[i]->getX();
-                float dy = heroY - hgarray[i]->getY();
-                float distance = sqrt(dx * dx + dy * dy);
-                if (distance < min_distance) {
-                    min_distance = distance;
-                    closestEnemy = hgarray[i];
-                }
-            }
-        }
-        for (unsigned int i = 0; i < slimeSize; i++) {
-            if (sarray[i]) {
-                float dx = heroX - sarray[i]->getX();
-                float dy = heroY - sarray[i]->getY();
-                float distance = sqrt(dx * dx + dy * dy);
-                if (distance < min_distance) {
-                    min_distance = distance;
-                    closestEnemy = sarray[i];
-                }
-            }
-        }
-        for (unsigned int i = 0; i < musketeerSize; i++) { 
-            if (marray[i]) { 
-                float dx = heroX - marray[i]->getX();
-                float dy = heroY - marray[i]->getY(); 
-                float distance = sqrt(dx * dx + dy * dy);
-                if (distance < min_distance) {
-                    min_distance = distance;
-                    closestEnemy = marray[i]; 
-                }
+        for (unsigned int i = 0; i < enemies.size(); i++) {
+            float dx = heroX - enemies.x[i]; // horizontal distance to hero
+            float dy = heroY - enemies.y[i]; // vertical distance to hero
+            float distance = sqrt(dx * dx + dy * dy); // Euclidean distance as we use this everywhere
+            if (distance < min_distance) { // if this enemy is closer than the current closest one
+                min_distance = distance; // update the minimum distance
+                closestEnemy = (int)i; // remember this enemy
             }
         }
         return closestEnemy;
     }
 
+    float getEnemyX(int i) {
+        return enemies.x[i];
+    }
+    float getEnemyY(int i) {
+        return enemies.y[i];
+    }
+
     void applyTopNHealthDamage(float damage,Hero& hero) {
         float aoeRange = 200.0f; // it has the range of 200
         unsigned int topN = 5; // we apply top 5 the area damage
-        int affected = 0;
-        const unsigned int maxEnemies = 1000; //assuming that there won't be more than 5000 enemies
-        Enemy* enemyList[maxEnemies];
-        int enemyHealth[maxEnemies];
-        unsigned int enemyCount = 0;
-
-        // for goblins
-        for (unsigned int i = 0; i < goblinSize; i++) {
-            if (enemyCount < maxEnemies) {
-                if (garray[i]) {
-                    enemyList[enemyCount] = garray[i];
-                    enemyHealth[enemyCount] = garray[i]->getHealth();
-                    enemyCount++;
-                }
-            }
-        }
-        // heavy goblins
-        for (unsigned int i = 0; i < heavyGoblinSize; i++) {
-            if (enemyCount < maxEnemies) {
-                if (hgarray[i]) {
-                    enemyList[enemyCount] = hgarray[i];
-                    enemyHealth[enemyCount] = hgarray[i]->getHealth();
-                    enemyCount++;
-                }
-            }     
-        }
-        // slimes
-        for (unsigned int i = 0; i < slimeSize; i++) {
-            if (enemyCount < maxEnemies) {
-                if (sarray[i]) {
-                    enemyList[enemyCount] = sarray[i];
-                    enemyHealth[enemyCount] = sarray[i]->getHealth();
-                    enemyCount++;
-                }
-            } 
-        }
-        // flying eyes
-        for (unsigned int i = 0; i < musketeerSize; i++) {
-            if (enemyCount < maxEnemies) {
-                if (marray[i]) {
-                    enemyList[enemyCount] = marray[i];
-                    enemyHealth[enemyCount] = marray[i]->getHealth();
-                    enemyCount++;
-                }
+
+        // the enemies in range are the only ones that can be hit
+        areaTargets.clear();
+        for (unsigned int i = 0; i < enemies.size(); i++) {
+            float dx = hero.getX() - enemies.x[i];
+            float dy = hero.getY() - enemies.y[i];
+            if (dx * dx + dy * dy <= aoeRange * aoeRange) {
+                areaTargets.push_back(i);
             }
         }
 
-        // sorting the healths using selection sort algorithm
-        for (unsigned int i = 0; i < enemyCount; i++) {
-            unsigned int maxIndex = i;
-            for (unsigned int j = i + 1; j < enemyCount; j++) {
-                if (enemyHealth[j] > enemyHealth[maxIndex]) {
-                    maxIndex = j;
-                }
-            }
-            if (maxIndex != i) {
-                int tempHealth = enemyHealth[i];
-                enemyHealth[i] = enemyHealth[maxIndex];
-                enemyHealth[maxIndex] = tempHealth;
-                Enemy* tempEnemy = enemyList[i];
-                enemyList[i] = enemyList[maxIndex];
-                enemyList[maxIndex] = tempEnemy;
-            }
+        //damage the top 5 enemy with the most health, we only need the first 5 in order so the rest isn't sorted
+        unsigned int affected = min(topN, (unsigned int)areaTargets.size());
+        const vector<int>& health = enemies.health;
+        partial_sort(areaTargets.begin(), areaTargets.begin() + affected, areaTargets.end(),
+            [&health](int a, int b) { return health[a] > health[b]; });
+        for (unsigned int i = 0; i < affected; i++) {
+            enemies.damage(areaTargets[i], damage);
         }
-        //damage the top 5 enemy with the most health
+    }
 
-        for (unsigned int i = 0; i < enemyCount; i++) {
-            if (affected >= topN)
-                break;
+    void spawnProjectile(float sx, float sy, float tx, float ty, float dmg, bool fromHero) {
+        projectiles.launch(sx, sy, tx, ty, dmg, fromHero); // the pool's policy decides what happens if all of them are in use
+    }
 
-            float dx = hero.getX() - enemyList[i]->getX();
-            float dy = hero.getY() - enemyList[i]->getY();
-            float distanceSquared = dx * dx + dy * dy;
+    // how many projectiles were lost because the pool was full
+    unsigned int getDroppedProjectiles() const {
+        return projectiles.getDropped();
+    }
 
-            if (distanceSquared <= aoeRange * aoeRange) {
-                enemyList[i]->getDamage(damage);
-                affected++;
-            }
+    // how often every enemy type touched the hero in this level, for the fps log
+    void writeContactHits(ostream& out) const {
+        for (unsigned int t = 0; t < enemyTypes.size(); t++) {
+            out << (t > 0 ? ", " : "") << enemyTypes[t].name << " " << contactTotals[t];
         }
     }
 
-    void spawnProjectile(float sx, float sy, float tx, float ty, float dmg, bool fromHero) {
-        for (unsigned int i = 0; i < maxProjectiles; i++) {
-            if (!projectiles[i].isActive()) {
-                projectiles[i].launch(sx, sy, tx, ty, dmg, fromHero); 
-                return;
-            }
-        }
+    // copies everything that is saved, this is all the main thread does for a save
+    void captureSnapshot(GameSnapshot& snapshot, const Hero& hero, bool isInfinite) const {
+        snapshot.hero = hero.getState();
+        snapshot.isInfinite = isInfinite;
+        snapshot.typeCount = (unsigned int)enemyTypes.size();
+        snapshot.enemies = enemies;
+        snapshot.projectiles = projectiles;
+        snapshot.seed = sessionSeed;
+        spawnRandom.getState(snapshot.randomState);
     }
 
+    // the save file is written on the save thread, the game goes on right away
     void saveGame(Hero& hero, bool isInfinite) {
-        ofstream file("savegame.txt"); // we create the save file
-
-        // we save the hero
-        hero.saveState(file);
-
-        // save the world
-        file << isInfinite << "\n";
+        auto snapshot = make_shared<GameSnapshot>();
+        captureSnapshot(*snapshot, hero, isInfinite);
+        SaveCodec codec = saveCodec;
+        saveWriter.run([snapshot, codec] {
+            string data, packed;
+            encodeSnapshot(*snapshot, data);
+            compressSave(data, codec, packed); // packed on the save thread too
+            SaveWriter::writeFileNow("savegame.sav", packed); // we create the save file
+        });
+    }
 
-        // save the number of enemies
-        file << goblinSize << " " << heavyGoblinSize << " " << slimeSize << " " << musketeerSize << "\n";
+    // puts a checked binary save into the game, every column is one copy
+    void applySnapshot(const SnapshotView& view, Hero& hero, bool& isInfinite) {
+        using namespace SnapshotFormat;
+        hero.setState(*view.column<HeroState>(SectionHero));
+        isInfinite = view.header.isInfinite != 0;
+        enemies.assignColumns(view.counts[SectionEnemyX], view.column<float>(SectionEnemyX), view.column<float>(SectionEnemyY),
+            view.column<int32_t>(SectionEnemyHealth), view.column<float>(SectionEnemyAttackTimer),
+            view.column<unsigned char>(SectionEnemyType), view.column<unsigned int>(SectionEnemyId));
+        projectiles.assignColumns(view.counts[SectionProjectileX], view.column<float>(SectionProjectileX),
+            view.column<float>(SectionProjectileY), view.column<float>(SectionProjectileDx), view.column<float>(SectionProjectileDy),
+            view.column<float>(SectionProjectileDamage), view.column<unsigned char>(SectionProjectileFromHero),
+            view.column<unsigned int>(SectionProjectileSerial));
+        sessionSeed = view.header.seed;
+        spawnRandom.setState(view.header.randomState);
+    }
 
-        // save the state of each enemy
-        for (unsigned int i = 0; i < goblinSize; i++) { 
-            garray[i]->saveState(file);
-        }
-        for (unsigned int i = 0; i < heavyGoblinSize; i++) {
-            hgarray[i]->saveState(file); 
+    // maps a binary save file and checks it, false if it is missing, broken or saved with other enemy types.
+    // a packed file is unpacked into unpacked, the view points into it or else into the mapped file
+    bool readBinarySave(const string& filename, MappedFile& file, vector<unsigned char>& unpacked, SnapshotView& view) {
+        if (!file.open(filename)) {
+            return false;
         }
-        for (unsigned int i = 0; i < slimeSize; i++) { 
-            sarray[i]->saveState(file);
+        const unsigned char* data = file.getData();
+        size_t size = file.getSize();
+        string error;
+        if (isCompressedSave(data, size)) {
+            if (!decompressSave(data, size, unpacked, error)) {
+                cout << "Error: " << filename << " can't be loaded, " << error << endl;
+                return false;
+            }
+            data = unpacked.data();
+            size = unpacked.size();
         }
-        for (unsigned int i = 0; i < musketeerSize; i++) { 
-            marray[i]->saveState(file); 
+        if (!decodeSnapshot(data, size, view, error)) {
+            cout << "Error: " << filename << " can't be loaded, " << error << endl;
+            return false;
         }
-
-        // save each projectile
-        for (unsigned int i = 0; i < maxProjectiles; i++) {
-            projectiles[i].saveState(file);
+        if (view.header.typeCount != enemyTypes.size()) {
+            cout << "Error: " << filename << " was saved with other enemy types" << endl;
+            return false;
         }
-
-        file.close();
+        return true;
     }
 
-    void loadGame(Hero& hero, bool& isInfinite) { 
-        ifstream file("savegame.txt");
-        if (!file.is_open()) return;
-
-        // first we delete all the
-        for (unsigned int i = 0; i < goblinSize; i++) delete garray[i];
-        for (unsigned int i = 0; i < heavyGoblinSize; i++) delete hgarray[i];
-        for (unsigned int i = 0; i < slimeSize; i++) delete sarray[i];
-        for (unsigned int i = 0; i < musketeerSize; i++) delete marray[i];
-        // deactivate all projectiles
-        for (unsigned int i = 0; i < maxProjectiles; i++) projectiles[i].deactivate();
+    // reads the old text save file, the saves from before the binary file can still be loaded
+    bool readTextSave(istream& file, Hero& hero, bool& isInfinite) {
+        // first we remove all the enemies and projectiles
+        clearEntities();
 
         // load hero's state
         hero.loadState(file);
@@ -854,40 +525,123 @@ public:
         file >> isInfinite;
 
         // load size of the enemies
-        unsigned int savedGoblinSize, savedHeavySize, savedSlimeSize, savedmusketeerSize;
-        file >> savedGoblinSize >> savedHeavySize >> savedSlimeSize >> savedmusketeerSize;
+        vector<unsigned int> savedSize(enemyTypes.size(), 0);
+        for (unsigned int t = 0; t < enemyTypes.size(); t++) {
+            file >> savedSize[t];
+        }
 
         // we create new enemies
-        goblinSize = savedGoblinSize;
-        for (unsigned int i = 0; i < goblinSize; i++) {
-            garray[i] = new Goblin(0, 0, "Resources/Goblin - Idle.png", "Resources/Goblin - Walk.png");
-            garray[i]->loadState(file); 
+        for (unsigned int t = 0; t < enemyTypes.size(); t++) {
+            for (unsigned int i = 0; i < savedSize[t]; i++) {
+                unsigned int index = enemies.spawn((unsigned char)t, 0, 0, enemyTypes[t].health);
+                loadEnemy(enemies, index, file);
+            }
         }
 
-        heavyGoblinSize = savedHeavySize;
-        for (unsigned int i = 0; i < heavyGoblinSize; i++) {
-            hgarray[i] = new HeavyGoblin(0, 0, "Resources/H_Goblin - Idle.png", "Resources/H_Goblin - Walk.png");
-            hgarray[i]->loadState(file);
+        // load projectiles
+        projectiles.loadState(file);
+        if (!file) {
+            return false;
         }
 
-        slimeSize = savedSlimeSize;
-        for (unsigned int i = 0; i < slimeSize; i++) {
-            sarray[i] = new Slime(0, 0, "Resources/Slime - Idle.png", "Resources/Slime - Walk.png");
-            sarray[i]->loadState(file);
+        // load the random state if the save has it, otherwise the stream of the new session is kept
+        uint64_t savedSeed = 0;
+        uint32_t state[4];
+        if (file >> savedSeed >> state[0] >> state[1] >> state[2] >> state[3]) {
+            sessionSeed = savedSeed;
+            spawnRandom.setState(state);
         }
 
-        musketeerSize = savedmusketeerSize;
-        for (unsigned int i = 0; i < musketeerSize; i++) {
-            marray[i] = new Musketeer(0, 0, "Resources/Musketeer.png", 250);
-            marray[i]->loadState(file);
+        // the ids in the same order as the entities were loaded, if the save has them
+        unsigned int n = 0;
+        if (file >> n && n == enemies.size()) {
+            for (unsigned int i = 0; i < n; i++) {
+                file >> enemies.id[i];
+            }
+            if (file >> n && n == projectiles.size()) {
+                for (unsigned int i = 0; i < n; i++) {
+                    file >> projectiles.serial[i];
+                }
+            }
         }
+        return true;
+    }
 
-        // load projectiles
-        for (unsigned int i = 0; i < maxProjectiles; i++) {
-            projectiles[i].loadState(file);
+    // new ids have to continue after the loaded ones
+    void continueIds() {
+        unsigned int nextEnemy = 0;
+        for (unsigned int i = 0; i < enemies.size(); i++) {
+            nextEnemy = max(nextEnemy, enemies.id[i] + 1);
+        }
+        enemies.nextId = max(enemies.nextId, nextEnemy);
+        unsigned int nextSerial = 0;
+        for (unsigned int i = 0; i < projectiles.size(); i++) {
+            nextSerial = max(nextSerial, projectiles.serial[i] + 1);
         }
+        projectiles.setNextSerial(nextSerial);
+    }
 
-        file.close();
+    void loadGame(Hero& hero, bool& isInfinite) { 
+        saveWriter.wait(); // a save that is still being written has to finish first
+        MappedFile mapped;
+        vector<unsigned char> unpacked;
+        SnapshotView view;
+        if (readBinarySave("savegame.sav", mapped, unpacked, view)) {
+            applySnapshot(view, hero, isInfinite);
+        }
+        else {
+            ifstream file("savegame.txt");
+            if (!file.is_open()) return;
+            bool loaded = readTextSave(file, hero, isInfinite);
+            file.close();
+            if (!loaded) {
+                // a broken file would leave half a game, the level starts fresh instead
+                clearEntities();
+                hero.reset(500, 400);
+                isInfinite = false;
+                cout << "Error: savegame.txt is broken, the game was not loaded" << endl;
+                return;
+            }
+        }
+        continueIds();
+        rebuildEnemyGrid();
+        autosave.invalidate(); // the next autosave starts from the loaded game
         std::cout << "Game loaded successfully" << endl;
     }
-};
\ No newline at end of file
+
+    // called every frame, it saves a journal entry every few seconds and a full checkpoint now and then
+    void autosaveStep(float dt, Hero& hero, bool isInfinite) {
+        Autosave::Step step = autosave.update(dt);
+        if (step == Autosave::Checkpoint) {
+            auto snapshot = make_shared<GameSnapshot>();
+            captureSnapshot(*snapshot, hero, isInfinite);
+            autosave.writeCheckpoint(snapshot);
+        }
+        else if (step == Autosave::Journal) {
+            auto frame = make_shared<GameSnapshot>(); // only copied here, the save thread finds what changed
+            captureSnapshot(*frame, hero, isInfinite);
+            autosave.writeJournal(frame);
+        }
+    }
+
+    // loads the last checkpoint and plays the journal on top of it
+    bool loadAutosave(Hero& hero, bool& isInfinite) {
+        saveWriter.wait();
+        MappedFile mapped;
+        vector<unsigned char> unpacked;
+        SnapshotView view;
+        if (!readBinarySave(autosave.getSnapshotFile(), mapped, unpacked, view)) {
+            cout << "Error: the autosave can't be loaded" << endl;
+            return false;
+        }
+        applySnapshot(view, hero, isInfinite);
+        mapped.close();
+        unsigned int checkpoint = view.header.checkpoint;
+        unsigned int entries = autosave.applyJournal(view.header.checksum, hero, enemies, projectiles, enemyTypes);
+        continueIds();
+        rebuildEnemyGrid();
+        autosave.invalidate();
+        std::cout << "Autosave loaded, checkpoint " << checkpoint << " and " << entries << " journal entries" << endl;
+        return true;
+    }
+};
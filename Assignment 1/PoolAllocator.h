@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <new>
+using namespace std;
+
+// The PoolArena hands out small blocks cut from big slabs. Every block size (in steps of 16 bytes) has its own free
+// list, so giving a block back and taking it again is just moving a pointer, and the slabs stay allocated for the
+// whole life of the arena. Containers that allocate one node per entity (the maps of the autosave have one entry
+// for every enemy and projectile) use it through PoolAllocator, so spawning and removing entities doesn't call
+// malloc and free all the time and the heap doesn't get fragmented by thousands of tiny blocks.
+// Anything bigger than maxBlock, like the bucket array of a map, goes to the normal heap.
+// The slabs are only freed with the arena, so an arena that lives as long as a load or a level gives everything
+// back at once instead of block by block.
+class PoolArena {
+    static const size_t granularity = 16;
+    static const size_t maxBlock = 256;
+    static const size_t slabSize = 64 * 1024;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    FreeBlock* freeLists[maxBlock / granularity] = {};
+    vector<unsigned char*> slabs;
+    unsigned char* slab = nullptr; // new blocks are cut from this one
+    size_t slabUsed = 0;
+
+    static size_t sizeClass(size_t size) {
+        return (size > 0) ? (size - 1) / granularity : 0;
+    }
+
+public:
+    PoolArena() {}
+    ~PoolArena() {
+        for (unsigned char* s : slabs) {
+            ::operator delete(s);
+        }
+    }
+
+    PoolArena(const PoolArena&) = delete;
+    PoolArena& operator=(const PoolArena&) = delete;
+
+    void* allocate(size_t size) {
+        if (size > maxBlock) {
+            return ::operator new(size);
+        }
+        size_t c = sizeClass(size);
+        if (freeLists[c]) {
+            FreeBlock* block = freeLists[c];
+            freeLists[c] = block->next;
+            return block;
+        }
+        size_t bytes = (c + 1) * granularity;
+        if (!slab || slabUsed + bytes > slabSize) {
+            slabs.push_back((unsigned char*)::operator new(slabSize)); // the rest of the old slab is left unused
+            slab = slabs.back();
+            slabUsed = 0;
+        }
+        void* block = slab + slabUsed;
+        slabUsed += bytes;
+        return block;
+    }
+
+    // size must be the size the block was allocated with
+    void deallocate(void* p, size_t size) {
+        if (size > maxBlock) {
+            ::operator delete(p);
+            return;
+        }
+        FreeBlock* block = (FreeBlock*)p;
+        size_t c = sizeClass(size);
+        block->next = freeLists[c];
+        freeLists[c] = block;
+    }
+
+};
+
+// lets the standard containers take their nodes from a PoolArena. all the copies share the arena, so a container
+// and its rebound allocators give the blocks back to the same place
+template <typename T>
+class PoolAllocator {
+public:
+    typedef T value_type;
+
+    PoolArena* arena;
+
+    explicit PoolAllocator(PoolArena& _arena) : arena(&_arena) {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        return (T*)arena->allocate(n * sizeof(T));
+    }
+
+    void deallocate(T* p, size_t n) {
+        arena->deallocate(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const {
+        return arena == other.arena;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& other) const {
+        return arena != other.arena;
+    }
+};
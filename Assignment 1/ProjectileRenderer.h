@@ -0,0 +1,102 @@
+#pragma once
+#include "GamesEngineeringBase.h"
+#include "Blitter.h"
+#include "Raster.h"
+#include "Projectiles.h"
+#include <vector>
+using namespace std;
+
+// The ProjectileRenderer draws all the projectiles of a frame in one batch.
+// Drawing them one by one meant working out the camera offset, rasterizing the same radius 3 disc and checking
+// who fired it again for every single projectile. Now the manager adds the screen position of every live projectile
+// to the bucket of its colour (the ones outside of the view are dropped right there), and draw() stamps a disc that
+// was rasterized once into row spans. Discs that are fully on the screen skip clipping and write whole words.
+class ProjectileRenderer {
+public:
+    enum Bucket { HeroBucket, EnemyBucket, BucketCount };
+
+private:
+    int radius;
+    vector<int> halfWidth; // the disc as spans, row dy - radius covers -halfWidth .. +halfWidth
+    vector<int> points[BucketCount]; // screen x, y pairs of the projectiles in every colour
+    unsigned char colours[BucketCount][3] = { { 0, 0, 255 }, { 255, 0, 0 } }; // hero projectiles are blue, enemy ones red
+    int viewWidth = 0;
+    int viewHeight = 0;
+
+    void stamp(const Surface& target, int cx, int cy, unsigned int colour, const unsigned char* rgb) {
+        if (target.bytesPerPixel == 4 && cx - radius >= 0 && cy - radius >= 0 && cx + radius < target.width && cy + radius < target.height) {
+            // the whole disc is on the screen so every span can be written without clipping
+            for (int row = 0; row <= radius * 2; row++) {
+                int w = halfWidth[row];
+                unsigned int* dst = target.row32(cy - radius + row) + cx - w;
+                for (int i = 0; i <= w * 2; i++) {
+                    dst[i] = colour;
+                }
+            }
+            return;
+        }
+        for (int row = 0; row <= radius * 2; row++) {
+            int w = halfWidth[row];
+            Raster::fillSpan(target, cy - radius + row, cx - w, cx + w + 1, rgb[0], rgb[1], rgb[2]);
+        }
+    }
+
+public:
+    // builds the disc once, the same pixels as testing dx * dx + dy * dy <= radius * radius
+    ProjectileRenderer(int _radius = 3) : radius(_radius) {
+        halfWidth.resize(radius * 2 + 1);
+        for (int dy = -radius; dy <= radius; dy++) {
+            int w = radius;
+            while (w > 0 && w * w + dy * dy > radius * radius) {
+                w--;
+            }
+            halfWidth[dy + radius] = w;
+        }
+    }
+
+    // makes room for every projectile once so adding them never allocates during the game
+    void reserve(unsigned int count) {
+        for (int i = 0; i < BucketCount; i++) {
+            points[i].reserve(count * 2);
+        }
+    }
+
+    // starts a new batch for a view of the given size
+    void begin(int _viewWidth, int _viewHeight) {
+        viewWidth = _viewWidth;
+        viewHeight = _viewHeight;
+        for (int i = 0; i < BucketCount; i++) {
+            points[i].clear();
+        }
+    }
+
+    // adds a projectile at screen position (sx, sy), it is dropped if no pixel of it would be visible
+    void add(int sx, int sy, Bucket bucket) {
+        if (sx + radius < 0 || sy + radius < 0 || sx - radius >= viewWidth || sy - radius >= viewHeight) {
+            return;
+        }
+        points[bucket].push_back(sx);
+        points[bucket].push_back(sy);
+    }
+
+    // adds every live projectile, each one goes to the bucket of its colour
+    void addAll(const ProjectileArchetype& projectiles, float camX, float camY) {
+        for (unsigned int i = 0; i < projectiles.size(); i++) {
+            add((int)(projectiles.x[i] - camX), (int)(projectiles.y[i] - camY), projectiles.fromHero[i] ? HeroBucket : EnemyBucket); // hero projectiles are blue, enemy ones red
+        }
+    }
+
+    // draws the whole batch one colour after the other
+    void draw(GamesEngineeringBase::Window& canvas) {
+        Surface target(canvas);
+        for (int b = 0; b < BucketCount; b++) {
+            const unsigned char* rgb = colours[b];
+            unsigned int colour = GamesEngineeringBase::Window::packPixel(rgb[0], rgb[1], rgb[2]);
+            const vector<int>& p = points[b];
+            for (unsigned int i = 0; i < p.size(); i += 2) {
+                Blitter::markDirty(p[i] - radius, p[i + 1] - radius, radius * 2 + 1, radius * 2 + 1); // so the dirty tracker erases it next frame
+                stamp(target, p[i], p[i + 1], colour, rgb);
+            }
+        }
+    }
+};
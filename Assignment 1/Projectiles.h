@@ -0,0 +1,324 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <iostream>
+#include <algorithm>
+using namespace std;
+
+// what happens to a new projectile when every slot is in use
+enum PoolFullPolicy {
+    DropNewest = 0, // the new projectile is not fired
+    DropOldest = 1 // the projectiles that were fired first make room for it
+};
+
+// The ProjectileArchetype keeps only the live projectiles, as columns like the enemies. The manager used to walk all
+// 30000 Projectile objects every frame and skip the inactive ones, now every loop only sees projectiles that exist.
+// A projectile that hits something or leaves the map is removed by moving the last one into its place.
+// Enemies fire together with launchBatch(): the columns grow once for the whole batch and the directions are worked
+// out in one loop. When the pool is full the policy decides which projectiles are lost and every lost one is counted.
+class ProjectileArchetype {
+    unsigned int count = 0;
+    unsigned int capacity = 0;
+    PoolFullPolicy policy = DropNewest;
+    unsigned int nextSerial = 0;
+    unsigned int dropped = 0; // how many projectiles were lost because the pool was full
+    vector<unsigned int> evictOrder; // reused when the oldest projectiles are dropped
+    static const unsigned int evictSlice = 32; // a full pool drops at least 1/32 of its projectiles at once
+    float lastStep = 0.0f;
+    double travelled = 0.0; // how far every projectile has moved since the start, the autosave journal uses it
+
+    // removes the k projectiles that were fired first
+    void dropOldest(unsigned int k) {
+        k = min(k, count);
+        if (k == 0) {
+            return;
+        }
+        evictOrder.resize(count);
+        for (unsigned int i = 0; i < count; i++) {
+            evictOrder[i] = i;
+        }
+        // we only need to know which k are the oldest, not their order
+        nth_element(evictOrder.begin(), evictOrder.begin() + (k - 1), evictOrder.end(),
+            [this](unsigned int a, unsigned int b) { return serial[a] - serial[b] > 0x80000000u; }); // wraps around safely
+        // removing from the highest index down means the last row that moves in is never one we still have to remove
+        sort(evictOrder.begin(), evictOrder.begin() + k, [](unsigned int a, unsigned int b) { return a > b; });
+        for (unsigned int i = 0; i < k; i++) {
+            remove(evictOrder[i]);
+        }
+        dropped += k;
+    }
+
+    // makes room for n new projectiles and returns how many of them can be fired
+    unsigned int makeRoom(unsigned int n) {
+        unsigned int room = capacity - count;
+        if (n <= room) {
+            return n;
+        }
+        if (policy == DropOldest) {
+            unsigned int fit = min(n, capacity);
+            // a full pool stays full while enemies keep firing, so we drop a slice of the pool at once and the next
+            // launches find free slots instead of searching the whole pool for the oldest every time
+            dropOldest(max(fit - room, capacity / evictSlice));
+            dropped += n - fit; // a batch larger than the whole pool still loses its newest ones
+            return fit;
+        }
+        dropped += n - room;
+        return room;
+    }
+
+public:
+    // position
+    vector<float> x, y;
+    // unit direction, every projectile flies with the same speed
+    vector<float> dx, dy;
+    vector<float> damage;
+    vector<unsigned char> fromHero; // 1 = hero projectile, 0 = enemy projectile
+    vector<unsigned int> serial; // when it was fired, the smallest one is the oldest
+
+    static constexpr float speed = 100.0f;
+    static constexpr float radius = 3.0f;
+    static const unsigned int legacySaveSlots = 30000; // the old text save has a line for every one of these slots
+
+    // the most projectiles that can exist at once, the columns are allocated for all of them once
+    void setCapacity(unsigned int n) {
+        capacity = n;
+        x.reserve(n);
+        y.reserve(n);
+        dx.reserve(n);
+        dy.reserve(n);
+        damage.reserve(n);
+        fromHero.reserve(n);
+        serial.reserve(n);
+        evictOrder.reserve(n);
+    }
+
+    // reads the pool settings, the current ones stay for anything that isn't in the file
+    bool loadSettings(const string& filename) {
+        ifstream infile(filename);
+        if (!infile.is_open()) {
+            cout << "Error: cannot open projectile file: " << filename << endl;
+            return false;
+        }
+        string line;
+        while (getline(infile, line)) {
+            if (line.empty() || line[0] == '#' || line[0] == '\r') {
+                continue;
+            }
+            stringstream parts(line);
+            string key;
+            parts >> key;
+            if (key == "capacity") {
+                unsigned int n = 0;
+                parts >> n;
+                if (n > 0) {
+                    setCapacity(n);
+                }
+            }
+            else if (key == "whenFull") {
+                string value;
+                parts >> value;
+                if (value == "dropOldest") policy = DropOldest;
+                else if (value == "dropNewest") policy = DropNewest;
+                else cout << "Warning: unknown whenFull " << value << " in " << filename << endl;
+            }
+            else cout << "Warning: unknown key " << key << " in " << filename << endl;
+        }
+        infile.close();
+        return true;
+    }
+
+    // after loading, the serials must continue after the largest loaded one
+    void setNextSerial(unsigned int n) {
+        nextSerial = n;
+    }
+
+    // the projectiles lost since the start, the main loop writes it to the log
+    unsigned int getDropped() const {
+        return dropped;
+    }
+
+    unsigned int size() const {
+        return count;
+    }
+
+    unsigned int getCapacity() const {
+        return capacity;
+    }
+
+    // x and y are the spawn points and tx and ty are target points, returns false if there is no room
+    bool launch(float _x, float _y, float tx, float ty, float dmg, bool FromHero) {
+        if (makeRoom(1) == 0) {
+            return false;
+        }
+        float vx = tx - _x;
+        float vy = ty - _y;
+        float len = sqrt(vx * vx + vy * vy);
+        float dirX = 0.0f;
+        float dirY = 0.0f;
+        if (len > 0.001f) {
+            dirX = vx / len; // dividing by length normalizes the direction vector (gives unit direction)
+            dirY = vy / len;
+        }
+        // if the shooter and target are too close we keep a zero direction to prevent division by zero
+        add(_x, _y, dirX, dirY, dmg, FromHero);
+        return true;
+    }
+
+    // fires n projectiles from (sx[i], sy[i]) at the same target, returns how many were fired.
+    // the columns are resized once and then every column is filled in its own loop, the direction loop has no
+    // branches so the compiler can vectorize it
+    unsigned int launchBatch(unsigned int n, const float* sx, const float* sy, const float* dmg, float tx, float ty, bool FromHero) {
+        n = makeRoom(n);
+        if (n == 0) {
+            return 0;
+        }
+        unsigned int base = count;
+        count += n;
+        x.resize(count);
+        y.resize(count);
+        dx.resize(count);
+        dy.resize(count);
+        damage.resize(count);
+        fromHero.resize(count, FromHero ? 1 : 0);
+        serial.resize(count);
+
+        float* outX = x.data() + base;
+        float* outY = y.data() + base;
+        float* outDx = dx.data() + base;
+        float* outDy = dy.data() + base;
+        for (unsigned int i = 0; i < n; i++) {
+            float vx = tx - sx[i];
+            float vy = ty - sy[i];
+            float lenSquared = vx * vx + vy * vy;
+            // a shooter on top of its target keeps a zero direction instead of dividing by zero
+            float inv = (lenSquared > 0.000001f) ? 1.0f / sqrt(lenSquared) : 0.0f;
+            outX[i] = sx[i];
+            outY[i] = sy[i];
+            outDx[i] = vx * inv;
+            outDy[i] = vy * inv;
+        }
+        copy(dmg, dmg + n, damage.data() + base);
+        for (unsigned int i = 0; i < n; i++) {
+            serial[base + i] = nextSerial++;
+        }
+        return n;
+    }
+
+    void add(float _x, float _y, float _dx, float _dy, float dmg, bool FromHero) {
+        x.push_back(_x);
+        y.push_back(_y);
+        dx.push_back(_dx);
+        dy.push_back(_dy);
+        damage.push_back(dmg);
+        fromHero.push_back(FromHero ? 1 : 0);
+        serial.push_back(nextSerial++);
+        count++;
+    }
+
+    // replaces every projectile with n loaded ones, the columns are copied in as they are
+    void assignColumns(unsigned int n, const float* xs, const float* ys, const float* dxs, const float* dys, const float* damages,
+        const unsigned char* fromHeroes, const unsigned int* serials) {
+        n = min(n, capacity);
+        x.assign(xs, xs + n);
+        y.assign(ys, ys + n);
+        dx.assign(dxs, dxs + n);
+        dy.assign(dys, dys + n);
+        damage.assign(damages, damages + n);
+        fromHero.assign(fromHeroes, fromHeroes + n);
+        serial.assign(serials, serials + n);
+        count = n;
+    }
+
+    // when projectile hits something or goes out, it is removed
+    void remove(unsigned int i) {
+        unsigned int last = count - 1;
+        if (i != last) {
+            x[i] = x[last];
+            y[i] = y[last];
+            dx[i] = dx[last];
+            dy[i] = dy[last];
+            damage[i] = damage[last];
+            fromHero[i] = fromHero[last];
+            serial[i] = serial[last];
+        }
+        x.pop_back();
+        y.pop_back();
+        dx.pop_back();
+        dy.pop_back();
+        damage.pop_back();
+        fromHero.pop_back();
+        serial.pop_back();
+        count--;
+    }
+
+    void clear() {
+        x.clear();
+        y.clear();
+        dx.clear();
+        dy.clear();
+        damage.clear();
+        fromHero.clear();
+        serial.clear();
+        count = 0;
+    }
+
+    // the movement system, position changes over time according to direction and speed.
+    // every projectile moves the same distance, so where it started this tick is x - dx * lastStep
+    void update(float dt) {
+        lastStep = speed * dt;
+        travelled += lastStep;
+        for (unsigned int i = 0; i < count; i++) {
+            x[i] += dx[i] * lastStep;
+            y[i] += dy[i] * lastStep;
+        }
+    }
+
+    // how far every projectile moved in the last update, the collision checks the whole way and not only the end
+    float getLastStep() const {
+        return lastStep;
+    }
+
+    // a projectile that was at (px, py) when travelled was t is now at (px, py) + direction * (getTravelled() - t)
+    double getTravelled() const {
+        return travelled;
+    }
+
+    // if the world is finite and a projectile leaves the boundaries we remove it.
+    // this runs after the collision so a projectile can still hit something on its way out
+    void removeOutOfWorld(bool isInfinite, float worldWidth, float worldHeight) {
+        if (!isInfinite) {
+            for (unsigned int i = 0; i < count; ) {
+                if (x[i] < 0 || y[i] < 0 || x[i] > worldWidth || y[i] > worldHeight) {
+                    remove(i); // the last projectile moved into i so we check i again
+                }
+                else {
+                    i++;
+                }
+            }
+        }
+    }
+
+    // reads the projectiles of the old text save, one line per slot: the active flag and then the state of a live one.
+    // the file always has legacySaveSlots lines whatever the capacity is now, the ones that don't fit are lost
+    void loadState(istream& file) {
+        clear();
+        for (unsigned int i = 0; i < legacySaveSlots; i++) {
+            bool active = false;
+            file >> active;
+            if (active) {
+                float _x, _y, _dx, _dy, dmg;
+                bool hero;
+                file >> _x >> _y >> _dx >> _dy >> dmg >> hero;
+                if (count < capacity) {
+                    add(_x, _y, _dx, _dy, dmg, hero);
+                }
+                else {
+                    dropped++;
+                }
+            }
+        }
+    }
+};
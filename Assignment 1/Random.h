@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <chrono>
+using namespace std;
+
+// every part of the game that needs random numbers gets its own stream, so drawing numbers in one of them never
+// changes what another one gets
+enum RandomStream {
+    StreamSpawn = 0, // where the enemies spawn
+    StreamAI = 1 // enemy decisions
+};
+
+// A small and fast generator (xoshiro128**) to replace rand(). rand() is one hidden global state, so two threads can't
+// use it at the same time and any extra call anywhere changes every number after it. A Random is a plain value that
+// belongs to whoever uses it, and the same seed always gives the same numbers on every machine.
+class Random {
+    uint32_t s[4];
+
+    static uint32_t rotl(uint32_t v, int k) {
+        return (v << k) | (v >> (32 - k));
+    }
+
+public:
+    // splitmix64 turns any seed (even 0 or 1) into a well mixed one, it is also used to derive the streams
+    static uint64_t splitMix(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    explicit Random(uint64_t seedValue = 0) {
+        seed(seedValue);
+    }
+
+    void seed(uint64_t seedValue) {
+        uint64_t state = seedValue;
+        uint64_t a = splitMix(state);
+        uint64_t b = splitMix(state);
+        s[0] = (uint32_t)a;
+        s[1] = (uint32_t)(a >> 32);
+        s[2] = (uint32_t)b;
+        s[3] = (uint32_t)(b >> 32);
+        if ((s[0] | s[1] | s[2] | s[3]) == 0) {
+            s[0] = 1; // the generator would only give zeros from an all zero state
+        }
+    }
+
+    uint32_t next() {
+        uint32_t result = rotl(s[1] * 5, 7) * 9;
+        uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+        return result;
+    }
+
+    // a number from 0 to n - 1, multiplying and keeping the high half is faster than % and doesn't favour small numbers as much
+    uint32_t below(uint32_t n) {
+        return (uint32_t)(((uint64_t)next() * n) >> 32);
+    }
+
+    // a number from 0 up to but not including 1
+    float uniform() {
+        return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // the saves keep the state so a loaded game continues with the same numbers
+    void getState(uint32_t out[4]) const {
+        for (int i = 0; i < 4; i++) {
+            out[i] = s[i];
+        }
+    }
+
+    void setState(const uint32_t in[4]) {
+        for (int i = 0; i < 4; i++) {
+            s[i] = in[i];
+        }
+        if ((s[0] | s[1] | s[2] | s[3]) == 0) {
+            s[0] = 1;
+        }
+    }
+};
+
+// The RandomService has the one seed of the session and hands out the streams made from it. With the seed a run can
+// be played again exactly, for example a run where the frame time was bad. index separates streams of the same kind:
+// the level, or the worker thread when several threads draw numbers at once, so they never share a generator.
+class RandomService {
+    uint64_t sessionSeed;
+
+public:
+    explicit RandomService(uint64_t seed = seedFromClock()) : sessionSeed(seed) {}
+
+    // a seed for when none was given on the command line
+    static uint64_t seedFromClock() {
+        return (uint64_t)chrono::high_resolution_clock::now().time_since_epoch().count();
+    }
+
+    uint64_t getSeed() const {
+        return sessionSeed;
+    }
+
+    void setSeed(uint64_t seed) {
+        sessionSeed = seed;
+    }
+
+    Random stream(RandomStream id, uint32_t index = 0) const {
+        uint64_t state = sessionSeed ^ ((uint64_t)id << 56) ^ ((uint64_t)index * 0xD1B54A32D192ED03ull);
+        return Random(Random::splitMix(state));
+    }
+};
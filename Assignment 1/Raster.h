@@ -0,0 +1,122 @@
+#pragma once
+#include "GamesEngineeringBase.h"
+#include "Blitter.h"
+using namespace std;
+
+// The Raster draws simple shapes (filled circles and rings) straight into a surface.
+// The AOE ring used to loop over the whole (2 * range + 1)^2 square and test x * x + y * y for every pixel, which is
+// about 160k tests for a 200 pixel range just to draw a ring 10 pixels wide. Here every scanline works out where the
+// shape starts and ends (the edge only moves a little from one row to the next so it is walked like in the midpoint
+// circle algorithm, no sqrt) and the pixels in between are filled as one span. A ring only touches its own pixels.
+class Raster {
+    // the widest x with x * x + dy * dy <= r2, starting the search from the result of the previous row.
+    // we walk the rows from the middle outwards so the edge only ever moves inwards
+    static int shrinkEdge(int x, int dy, int r2) {
+        while (x >= 0 && x * x + dy * dy > r2) {
+            x--;
+        }
+        return x;
+    }
+
+    // the smallest x with x * x + dy * dy >= r2, the edge of the hole moves inwards as well
+    static int shrinkHole(int x, int dy, int r2) {
+        while (x > 0 && (x - 1) * (x - 1) + dy * dy >= r2) {
+            x--;
+        }
+        return x;
+    }
+
+    // draws the two spans of a ring row, or one span when the hole doesn't reach this row
+    static void ringRow(const Surface& target, int cx, int y, int outer, int hole, unsigned char r, unsigned char g, unsigned char b) {
+        if (outer < 0 || hole > outer) {
+            return;
+        }
+        if (hole == 0) {
+            fillSpan(target, y, cx - outer, cx + outer + 1, r, g, b);
+            return;
+        }
+        fillSpan(target, y, cx - outer, cx - hole + 1, r, g, b);
+        fillSpan(target, y, cx + hole, cx + outer + 1, r, g, b);
+    }
+
+public:
+    // fills the pixels x0 .. x1 - 1 of row y, everything outside of the surface is clipped
+    static void fillSpan(const Surface& target, int y, int x0, int x1, unsigned char r, unsigned char g, unsigned char b) {
+        if (y < 0 || y >= target.height) {
+            return;
+        }
+        x0 = max(x0, 0);
+        x1 = min(x1, target.width);
+        if (x0 >= x1) {
+            return;
+        }
+        if (target.bytesPerPixel == 4) {
+            unsigned int* dst = target.row32(y);
+            unsigned int colour = GamesEngineeringBase::Window::packPixel(r, g, b);
+            for (int x = x0; x < x1; x++) {
+                dst[x] = colour;
+            }
+            return;
+        }
+        unsigned char* dst = target.row(y) + x0 * 3;
+        for (int x = x0; x < x1; x++) {
+            dst[0] = r;
+            dst[1] = g;
+            dst[2] = b;
+            dst += 3;
+        }
+    }
+
+    // a filled circle with every pixel that has dx * dx + dy * dy <= radius * radius
+    static void fillCircle(const Surface& target, int cx, int cy, int radius, unsigned char r, unsigned char g, unsigned char b) {
+        if (radius < 0) {
+            return;
+        }
+        int r2 = radius * radius;
+        int x = radius;
+        for (int dy = 0; dy <= radius; dy++) {
+            x = shrinkEdge(x, dy, r2);
+            fillSpan(target, cy + dy, cx - x, cx + x + 1, r, g, b);
+            if (dy != 0) {
+                fillSpan(target, cy - dy, cx - x, cx + x + 1, r, g, b);
+            }
+        }
+    }
+
+    // a ring with every pixel that has innerR2 <= dx * dx + dy * dy <= outerR2, the radii are given squared so
+    // the caller decides how to round them
+    static void fillRing(const Surface& target, int cx, int cy, int outerR2, int innerR2, unsigned char r, unsigned char g, unsigned char b) {
+        if (outerR2 < 0) {
+            return;
+        }
+        int radius = 0;
+        while ((radius + 1) * (radius + 1) <= outerR2) {
+            radius++; // the integer square root, only done once per ring
+        }
+        int outer = radius;
+        int hole = radius + 1;
+        for (int dy = 0; dy <= radius; dy++) {
+            outer = shrinkEdge(outer, dy, outerR2);
+            hole = shrinkHole(hole, dy, innerR2);
+            ringRow(target, cx, cy + dy, outer, hole, r, g, b);
+            if (dy != 0) {
+                ringRow(target, cx, cy - dy, outer, hole, r, g, b);
+            }
+        }
+    }
+
+    // the same shapes drawn on the canvas, the dirty tracker is told about their bounding box
+    static void fillCircle(GamesEngineeringBase::Window& canvas, int cx, int cy, int radius, unsigned char r, unsigned char g, unsigned char b) {
+        Blitter::markDirty(cx - radius, cy - radius, radius * 2 + 1, radius * 2 + 1);
+        fillCircle(Surface(canvas), cx, cy, radius, r, g, b);
+    }
+
+    static void fillRing(GamesEngineeringBase::Window& canvas, int cx, int cy, int outerR2, int innerR2, unsigned char r, unsigned char g, unsigned char b) {
+        int radius = 0;
+        while ((radius + 1) * (radius + 1) <= outerR2) {
+            radius++;
+        }
+        Blitter::markDirty(cx - radius, cy - radius, radius * 2 + 1, radius * 2 + 1);
+        fillRing(Surface(canvas), cx, cy, outerR2, innerR2, r, g, b);
+    }
+};
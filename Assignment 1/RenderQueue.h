@@ -0,0 +1,144 @@
+#pragma once
+#include "GamesEngineeringBase.h"
+#include "Blitter.h"
+#include <vector>
+using namespace std;
+
+// the layers are drawn from the lowest to the highest
+enum RenderLayer {
+    LayerGround = 0, // things lying on the floor
+    LayerActors = 1, // the hero and the enemies, sorted by where their feet are
+    LayerOverlay = 2 // always on top
+};
+
+// The RenderQueue collects the sprites of a frame and draws them in one go.
+// The draw order used to be fixed by the code: the hero first, then goblins, heavy goblins, slimes and musketeers, so
+// a goblin standing in front of the hero was still drawn behind the hero. Now the hero and the enemies only submit a draw
+// command and the queue sorts all of them by layer, then by the y of the bottom of the sprite (what is lower on the
+// screen is in front), then by texture so sprites of the same image end up next to each other.
+// The key is a 32-bit number so sorting is a radix sort over its four bytes, which is linear and stable: commands
+// with the same key stay in the order they were submitted.
+class RenderQueue {
+    struct Command {
+        const GamesEngineeringBase::Image* image;
+        int srcX, srcY, w, h;
+        int dstX, dstY; // screen position of the top left corner
+    };
+    struct SortItem {
+        unsigned int key;
+        unsigned int command; // index into commands
+    };
+
+    vector<Command> commands;
+    vector<SortItem> items;
+    vector<SortItem> scratch; // the radix sort moves the items back and forth between items and scratch
+    bool frontToBack = false; // draw from the front with a coverage mask instead of painting over
+    CoverageMask coverage;
+    unsigned int hiddenCount = 0; // sprites of the last frame that were skipped because they were completely behind others
+
+    // layer in the top 4 bits, the y in the next 16 and the texture in the lowest 12
+    static unsigned int makeKey(int layer, int sortY, int texture) {
+        int y = sortY + 32768; // the y can be a bit negative above the screen
+        if (y < 0) {
+            y = 0;
+        }
+        if (y > 0xFFFF) {
+            y = 0xFFFF;
+        }
+        return ((unsigned int)(layer & 0xF) << 28) | ((unsigned int)y << 12) | ((unsigned int)texture & 0xFFF);
+    }
+
+    void radixSort() {
+        scratch.resize(items.size());
+        vector<SortItem>* from = &items;
+        vector<SortItem>* to = &scratch;
+        for (int shift = 0; shift < 32; shift += 8) {
+            unsigned int count[257] = {};
+            for (unsigned int i = 0; i < from->size(); i++) {
+                count[(((*from)[i].key >> shift) & 0xFF) + 1]++;
+            }
+            if (count[(((*from)[0].key >> shift) & 0xFF) + 1] == from->size()) {
+                continue; // every key has the same byte here so this pass wouldn't change anything
+            }
+            for (int b = 0; b < 256; b++) {
+                count[b + 1] += count[b];
+            }
+            for (unsigned int i = 0; i < from->size(); i++) {
+                (*to)[count[((*from)[i].key >> shift) & 0xFF]++] = (*from)[i];
+            }
+            vector<SortItem>* swapTemp = from;
+            from = to;
+            to = swapTemp;
+        }
+        if (from != &items) {
+            items.swap(scratch);
+        }
+    }
+
+public:
+    // forgets the commands of the last frame, the memory is kept
+    void begin() {
+        commands.clear();
+        items.clear();
+    }
+
+    // queues the w x h part of img starting at (srcX, srcY) to be drawn at (dstX, dstY) on the screen.
+    // texture is the asset handle of the image and is only used to group the sprites of the same image
+    void submit(int texture, const GamesEngineeringBase::Image& img, int srcX, int srcY, int w, int h, int dstX, int dstY, RenderLayer layer = LayerActors) {
+        Command c;
+        c.image = &img;
+        c.srcX = srcX;
+        c.srcY = srcY;
+        c.w = w;
+        c.h = h;
+        c.dstX = dstX;
+        c.dstY = dstY;
+        SortItem item;
+        item.key = makeKey(layer, dstY + h, texture); // the bottom of the sprite decides what is in front
+        item.command = (unsigned int)commands.size();
+        commands.push_back(c);
+        items.push_back(item);
+    }
+
+    unsigned int size() const {
+        return (unsigned int)commands.size();
+    }
+
+    // in a dense swarm most enemy pixels are painted over by the enemies in front of them. front to back the queue
+    // draws the front sprites first and the ones behind only fill in what is still uncovered, so a crowd costs about
+    // the screen area it covers instead of its sprite count times the sprite area. the picture is the same.
+    // it needs a 32-bit canvas, on a 24-bit one the queue keeps painting back to front
+    void setFrontToBack(bool enabled) {
+        frontToBack = enabled;
+    }
+
+    // the sprites the coverage mask skipped in the last frame, always 0 when drawing back to front
+    unsigned int getHiddenCount() const {
+        return hiddenCount;
+    }
+
+    // sorts everything that was submitted and draws it through the blitter
+    void execute(GamesEngineeringBase::Window& canvas) {
+        if (items.empty()) {
+            return;
+        }
+        radixSort();
+        hiddenCount = 0;
+        if (frontToBack && canvas.getBytesPerPixel() == 4) {
+            Surface target(canvas);
+            coverage.reset(target.width, target.height);
+            for (unsigned int i = (unsigned int)items.size(); i-- > 0; ) { // the last in the sorted order is the front
+                const Command& c = commands[items[i].command];
+                Blitter::markDirty(c.dstX, c.dstY, c.w, c.h);
+                if (Blitter::drawImageFrontToBack(target, *c.image, c.srcX, c.srcY, c.w, c.h, c.dstX, c.dstY, coverage)) {
+                    hiddenCount++;
+                }
+            }
+            return;
+        }
+        for (unsigned int i = 0; i < items.size(); i++) {
+            const Command& c = commands[items[i].command];
+            Blitter::drawImage(canvas, *c.image, c.srcX, c.srcY, c.w, c.h, c.dstX, c.dstY);
+        }
+    }
+};
@@ -0,0 +1,153 @@
+#pragma once
+#include "InputState.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+using namespace std;
+
+// A replay is everything a level needs to be played again exactly: the seed of the random numbers, the level, the
+// attempt, the world mode and then for every tick the dt and the keys that were down. The game itself doesn't read the clock or
+// the keyboard anywhere else, so feeding the same ticks back gives the same game on any machine.
+// The file is binary and little endian no matter the machine:
+//   "SRPL", version (1 byte), seed (8 bytes), level (4 bytes), infinite world (1 byte), attempt (4 bytes)
+//   (version 1 files have no attempt, they were all played with the stream of attempt 0)
+//   then 6 bytes per tick: dt as a float and the key bits of InputState
+struct ReplayHeader {
+    uint64_t seed = 0;
+    int32_t level = 1;
+    bool isInfinite = false;
+    uint32_t attempt = 0;
+};
+
+namespace ReplayFormat {
+    const char magic[4] = { 'S', 'R', 'P', 'L' };
+    const unsigned char version = 2;
+
+    inline void writeBytes(ofstream& file, uint64_t value, int bytes) {
+        unsigned char buffer[8];
+        for (int i = 0; i < bytes; i++) {
+            buffer[i] = (unsigned char)(value >> (8 * i));
+        }
+        file.write((const char*)buffer, bytes);
+    }
+
+    inline bool readBytes(ifstream& file, uint64_t& value, int bytes) {
+        unsigned char buffer[8];
+        if (!file.read((char*)buffer, bytes)) {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value |= (uint64_t)buffer[i] << (8 * i);
+        }
+        return true;
+    }
+}
+
+// writes the ticks of a level while it is played
+class InputRecorder {
+    ofstream file;
+    unsigned int ticks = 0;
+
+public:
+    bool open(const string& filename, const ReplayHeader& header) {
+        file.open(filename, ios::binary);
+        if (!file.is_open()) {
+            cout << "Error: cannot create replay file: " << filename << endl;
+            return false;
+        }
+        file.write(ReplayFormat::magic, 4);
+        ReplayFormat::writeBytes(file, ReplayFormat::version, 1);
+        ReplayFormat::writeBytes(file, header.seed, 8);
+        ReplayFormat::writeBytes(file, (uint32_t)header.level, 4);
+        ReplayFormat::writeBytes(file, header.isInfinite ? 1 : 0, 1);
+        ReplayFormat::writeBytes(file, header.attempt, 4);
+        ticks = 0;
+        return true;
+    }
+
+    bool isOpen() const {
+        return file.is_open();
+    }
+
+    void record(float dt, const InputState& input) {
+        if (!file.is_open()) {
+            return;
+        }
+        uint32_t dtBits;
+        memcpy(&dtBits, &dt, 4); // the exact bits so the replay gets the exact same float
+        ReplayFormat::writeBytes(file, dtBits, 4);
+        ReplayFormat::writeBytes(file, input.getBits(), 2);
+        ticks++;
+    }
+
+    void close() {
+        if (file.is_open()) {
+            file.close();
+            cout << "Replay saved, " << ticks << " ticks" << endl;
+        }
+    }
+
+    ~InputRecorder() {
+        close();
+    }
+};
+
+// reads a replay back one tick at a time
+class InputPlayer {
+    ifstream file;
+    ReplayHeader header;
+    unsigned int ticks = 0;
+
+public:
+    bool open(const string& filename) {
+        file.open(filename, ios::binary);
+        if (!file.is_open()) {
+            cout << "Error: cannot open replay file: " << filename << endl;
+            return false;
+        }
+        char magic[4];
+        uint64_t version = 0, seed = 0, level = 0, infinite = 0, attempt = 0;
+        if (!file.read(magic, 4) || memcmp(magic, ReplayFormat::magic, 4) != 0 ||
+            !ReplayFormat::readBytes(file, version, 1) || version < 1 || version > ReplayFormat::version ||
+            !ReplayFormat::readBytes(file, seed, 8) || !ReplayFormat::readBytes(file, level, 4) ||
+            !ReplayFormat::readBytes(file, infinite, 1) || (version >= 2 && !ReplayFormat::readBytes(file, attempt, 4))) {
+            cout << "Error: " << filename << " is not a replay file of this version" << endl;
+            file.close();
+            return false;
+        }
+        header.seed = seed;
+        header.level = (int32_t)(uint32_t)level;
+        header.isInfinite = infinite != 0;
+        header.attempt = (uint32_t)attempt;
+        ticks = 0;
+        return true;
+    }
+
+    bool isOpen() const {
+        return file.is_open();
+    }
+
+    const ReplayHeader& getHeader() const {
+        return header;
+    }
+
+    unsigned int getTicks() const {
+        return ticks;
+    }
+
+    // the next tick, false when the replay is over
+    bool next(float& dt, InputState& input) {
+        uint64_t dtBits = 0, keys = 0;
+        if (!file.is_open() || !ReplayFormat::readBytes(file, dtBits, 4) || !ReplayFormat::readBytes(file, keys, 2)) {
+            return false;
+        }
+        uint32_t bits = (uint32_t)dtBits;
+        memcpy(&dt, &bits, 4);
+        input = InputState::fromBits((uint16_t)keys);
+        ticks++;
+        return true;
+    }
+};
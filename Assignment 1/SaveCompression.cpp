@@ -0,0 +1,353 @@
+#include "SaveCompression.h"
+#include <cstring>
+#include <algorithm>
+
+// the rules of the LZ4 block format: a match is at least 4 bytes and at most 65535 bytes back, the last 5 bytes are
+// always literals and no match starts in the last 12 bytes
+static const size_t minMatch = 4;
+static const size_t lastLiterals = 5;
+static const size_t matchLimit = 12;
+static const size_t maxOffset = 65535;
+
+static uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static uint32_t hash4(uint32_t v, int bits) {
+    return (v * 2654435761u) >> (32 - bits);
+}
+
+// how many bytes after a and b are the same, b is before a so a reaches the end first
+static size_t matchLength(const unsigned char* a, const unsigned char* b, const unsigned char* end) {
+    const unsigned char* start = a;
+    while (a + 4 <= end && read32(a) == read32(b)) {
+        a += 4;
+        b += 4;
+    }
+    while (a < end && *a == *b) {
+        a++;
+        b++;
+    }
+    return a - start;
+}
+
+static void writeLength(string& out, size_t length) {
+    while (length >= 255) {
+        out.push_back((char)255);
+        length -= 255;
+    }
+    out.push_back((char)length);
+}
+
+// one sequence: the literals and then the match that copies length bytes from offset back. the last sequence of a
+// chunk only has literals, its length is 0
+static void writeSequence(string& out, const unsigned char* literals, size_t literalCount, size_t offset, size_t length) {
+    size_t extra = (length > 0) ? length - minMatch : 0;
+    out.push_back((char)((min(literalCount, (size_t)15) << 4) | min(extra, (size_t)15)));
+    if (literalCount >= 15) {
+        writeLength(out, literalCount - 15);
+    }
+    out.append((const char*)literals, literalCount);
+    if (length == 0) {
+        return;
+    }
+    out.push_back((char)(offset & 255));
+    out.push_back((char)(offset >> 8));
+    if (extra >= 15) {
+        writeLength(out, extra - 15);
+    }
+}
+
+// the tables are kept for all the chunks of a file, they are only cleared for every chunk
+struct Packer {
+    static const int fastBits = 14;
+    static const int smallBits = 16;
+    static const size_t chainDepth = 64; // how many earlier places Small tries
+
+    vector<uint32_t> head; // the last position + 1 with this hash, 0 is empty
+    vector<uint32_t> chain; // the position + 1 before it with the same hash, by position & 0xFFFF
+
+    void packFast(const unsigned char* src, size_t n, string& out) {
+        head.assign((size_t)1 << fastBits, 0);
+        size_t anchor = 0;
+        size_t i = 0;
+        if (n > matchLimit) {
+            size_t limit = n - matchLimit;
+            const unsigned char* end = src + n - lastLiterals;
+            while (i < limit) {
+                uint32_t sequence = read32(src + i);
+                uint32_t h = hash4(sequence, fastBits);
+                size_t candidate = head[h];
+                head[h] = (uint32_t)i + 1;
+                if (candidate > 0 && i - (candidate - 1) <= maxOffset && read32(src + candidate - 1) == sequence) {
+                    size_t match = candidate - 1;
+                    while (i > anchor && match > 0 && src[i - 1] == src[match - 1]) { // the match may start earlier
+                        i--;
+                        match--;
+                    }
+                    size_t length = minMatch + matchLength(src + i + minMatch, src + match + minMatch, end);
+                    writeSequence(out, src + anchor, i - anchor, i - match, length);
+                    i += length;
+                    anchor = i;
+                    continue;
+                }
+                i += 1 + ((i - anchor) >> 6); // data that doesn't pack is skipped faster and faster, like lz4 does
+            }
+        }
+        writeSequence(out, src + anchor, n - anchor, 0, 0);
+    }
+
+    size_t inserted = 0; // the positions before this are in the chains
+
+    void insert(const unsigned char* src, size_t p) {
+        uint32_t h = hash4(read32(src + p), smallBits);
+        chain[p & maxOffset] = head[h];
+        head[h] = (uint32_t)p + 1;
+    }
+
+    // the longest match for position p, all the positions up to p are added to the chains first
+    size_t longestMatch(const unsigned char* src, size_t p, const unsigned char* end, size_t& offset) {
+        while (inserted < p) {
+            insert(src, inserted++);
+        }
+        size_t best = 0;
+        size_t candidate = head[hash4(read32(src + p), smallBits)];
+        for (size_t tries = 0; candidate > 0 && tries < chainDepth; tries++) {
+            size_t match = candidate - 1;
+            if (p - match > maxOffset) {
+                break; // the rest of the chain is even further back
+            }
+            if (src[match + best] == src[p + best] && read32(src + match) == read32(src + p)) {
+                size_t length = minMatch + matchLength(src + p + minMatch, src + match + minMatch, end);
+                if (length > best) {
+                    best = length;
+                    offset = p - match;
+                    if (src + p + length >= end) {
+                        break; // it can't get longer
+                    }
+                }
+            }
+            candidate = chain[match & maxOffset];
+        }
+        insert(src, p);
+        inserted = p + 1;
+        return best;
+    }
+
+    void packSmall(const unsigned char* src, size_t n, string& out) {
+        head.assign((size_t)1 << smallBits, 0);
+        chain.assign(maxOffset + 1, 0);
+        inserted = 0;
+        size_t anchor = 0;
+        size_t p = 0;
+        if (n > matchLimit) {
+            size_t limit = n - matchLimit;
+            const unsigned char* end = src + n - lastLiterals;
+            while (p < limit) {
+                size_t offset = 0;
+                size_t length = longestMatch(src, p, end, offset);
+                if (length < minMatch) {
+                    p++;
+                    continue;
+                }
+                // one byte later might start a longer match, then this byte goes to the literals
+                while (p + 1 < limit) {
+                    size_t nextOffset = 0;
+                    size_t nextLength = longestMatch(src, p + 1, end, nextOffset);
+                    if (nextLength <= length) {
+                        break;
+                    }
+                    p++;
+                    length = nextLength;
+                    offset = nextOffset;
+                }
+                writeSequence(out, src + anchor, p - anchor, offset, length);
+                p += length;
+                anchor = p;
+            }
+        }
+        writeSequence(out, src + anchor, n - anchor, 0, 0);
+    }
+};
+
+// unpacks one chunk, every length and offset is checked so a broken file can't write outside of dst
+static bool unpackChunk(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize) {
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < srcSize) {
+        unsigned char token = src[ip++];
+        size_t literalCount = token >> 4;
+        if (literalCount == 15) {
+            unsigned char b;
+            do {
+                if (ip >= srcSize) {
+                    return false;
+                }
+                b = src[ip++];
+                literalCount += b;
+            } while (b == 255);
+        }
+        if (literalCount > srcSize - ip || literalCount > dstSize - op) {
+            return false;
+        }
+        memcpy(dst + op, src + ip, literalCount);
+        ip += literalCount;
+        op += literalCount;
+        if (ip == srcSize) {
+            break; // the last sequence has no match
+        }
+
+        if (srcSize - ip < 2) {
+            return false;
+        }
+        size_t offset = src[ip] | ((size_t)src[ip + 1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) {
+            return false;
+        }
+        size_t length = token & 15;
+        if (length == 15) {
+            unsigned char b;
+            do {
+                if (ip >= srcSize) {
+                    return false;
+                }
+                b = src[ip++];
+                length += b;
+            } while (b == 255);
+        }
+        length += minMatch;
+        if (length > dstSize - op) {
+            return false;
+        }
+        unsigned char* d = dst + op;
+        const unsigned char* s = d - offset;
+        if (offset >= length) {
+            memcpy(d, s, length);
+        }
+        else {
+            for (size_t i = 0; i < length; i++) {
+                d[i] = s[i]; // the match overlaps what it writes, a run of the same bytes
+            }
+        }
+        op += length;
+    }
+    return op == dstSize;
+}
+
+bool parseSaveCodec(const string& name, SaveCodec& codec) {
+    if (name == "none") {
+        codec = CodecNone;
+    }
+    else if (name == "fast") {
+        codec = CodecFast;
+    }
+    else if (name == "small") {
+        codec = CodecSmall;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+void compressSave(const string& data, SaveCodec codec, string& out) {
+    using namespace CompressionFormat;
+    if (codec == CodecNone) {
+        out = data;
+        return;
+    }
+    Header header = {};
+    memcpy(header.magic, magic, 4);
+    header.version = version;
+    header.codec = codec;
+    header.chunkSize = chunkSize;
+    header.rawSize = data.size();
+    header.chunkCount = (uint32_t)((data.size() + chunkSize - 1) / chunkSize);
+
+    out.clear();
+    out.reserve(sizeof(Header) + data.size() / 2);
+    out.append((const char*)&header, sizeof(Header));
+
+    Packer packer;
+    string packed;
+    packed.reserve(chunkSize + chunkSize / 255 + 16);
+    const unsigned char* src = (const unsigned char*)data.data();
+    for (size_t start = 0; start < data.size(); start += chunkSize) {
+        size_t n = min((size_t)chunkSize, data.size() - start);
+        packed.clear();
+        if (codec == CodecSmall) {
+            packer.packSmall(src + start, n, packed);
+        }
+        else {
+            packer.packFast(src + start, n, packed);
+        }
+        Chunk chunk;
+        chunk.rawSize = (uint32_t)n;
+        if (packed.size() < n) {
+            chunk.packedSize = (uint32_t)packed.size();
+            out.append((const char*)&chunk, sizeof(Chunk));
+            out.append(packed);
+        }
+        else {
+            chunk.packedSize = (uint32_t)n | storedChunk;
+            out.append((const char*)&chunk, sizeof(Chunk));
+            out.append((const char*)src + start, n);
+        }
+    }
+}
+
+bool isCompressedSave(const unsigned char* data, size_t size) {
+    return size >= sizeof(CompressionFormat::Header) && memcmp(data, CompressionFormat::magic, 4) == 0;
+}
+
+bool decompressSave(const unsigned char* data, size_t size, vector<unsigned char>& out, string& error) {
+    using namespace CompressionFormat;
+    Header header;
+    memcpy(&header, data, sizeof(Header));
+    if (header.version != version || (header.codec != CodecFast && header.codec != CodecSmall) || header.chunkSize == 0) {
+        error = "the file is packed by another version";
+        return false;
+    }
+    if (header.chunkCount != (header.rawSize + header.chunkSize - 1) / header.chunkSize || header.rawSize > (uint64_t)size * 256) {
+        error = "the packed header is broken";
+        return false;
+    }
+    out.resize((size_t)header.rawSize);
+    size_t ip = sizeof(Header);
+    size_t op = 0;
+    for (uint32_t c = 0; c < header.chunkCount; c++) {
+        Chunk chunk;
+        if (size - ip < sizeof(Chunk)) {
+            error = "the file is cut off";
+            return false;
+        }
+        memcpy(&chunk, data + ip, sizeof(Chunk));
+        ip += sizeof(Chunk);
+        size_t packedSize = chunk.packedSize & ~storedChunk;
+        if (chunk.rawSize > header.chunkSize || chunk.rawSize > out.size() - op || packedSize > size - ip) {
+            error = "the file is cut off";
+            return false;
+        }
+        if (chunk.packedSize & storedChunk) {
+            if (packedSize != chunk.rawSize) {
+                error = "a chunk is broken";
+                return false;
+            }
+            memcpy(out.data() + op, data + ip, packedSize);
+        }
+        else if (!unpackChunk(data + ip, packedSize, out.data() + op, chunk.rawSize)) {
+            error = "a chunk is broken";
+            return false;
+        }
+        ip += packedSize;
+        op += chunk.rawSize;
+    }
+    if (op != out.size()) {
+        error = "chunks are missing";
+        return false;
+    }
+    return true;
+}
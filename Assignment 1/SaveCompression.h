@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+using namespace std;
+
+// How a save file is packed before it is written. Both packed kinds use the same LZ4 style format, so loading
+// doesn't care which one was used:
+// Fast only looks at one earlier place for a match, it packs a late game save in a few milliseconds.
+// Small follows a chain of earlier places and waits one byte for a longer match, slower but the files are smaller.
+enum SaveCodec : uint32_t {
+    CodecNone = 0,
+    CodecFast = 1,
+    CodecSmall = 2
+};
+
+// The packed file: a header and then the chunks one after the other. Every chunk is packed on its own, so the tables
+// of the packer stay small and loading can unpack chunk by chunk straight into the place it belongs.
+// A chunk that doesn't get smaller is stored as it is.
+namespace CompressionFormat {
+    const char magic[4] = { 'S', 'V', 'Z', 'C' };
+    const uint32_t version = 1;
+    const uint32_t chunkSize = 256 * 1024;
+    const uint32_t storedChunk = 0x80000000u; // set in packedSize when the chunk isn't packed
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t codec;
+        uint32_t chunkSize;
+        uint64_t rawSize;
+        uint32_t chunkCount;
+        uint32_t reserved;
+    };
+
+    struct Chunk {
+        uint32_t rawSize;
+        uint32_t packedSize; // the bytes that follow, with storedChunk if they are the raw bytes
+    };
+
+    static_assert(sizeof(Header) == 32, "the header is written as it is");
+    static_assert(sizeof(Chunk) == 8, "the chunk headers are written as they are");
+}
+
+// "none", "fast" or "small", false for anything else
+bool parseSaveCodec(const string& name, SaveCodec& codec);
+
+// packs a whole save file. with CodecNone the data is returned as it is, without a header
+void compressSave(const string& data, SaveCodec codec, string& out);
+
+// true if the file starts with the header of a packed save, an unpacked one is used as it is
+bool isCompressedSave(const unsigned char* data, size_t size);
+
+// unpacks a packed save, error says what was wrong if it is broken
+bool decompressSave(const unsigned char* data, size_t size, vector<unsigned char>& out, string& error);
@@ -0,0 +1,253 @@
+#pragma once
+#include "Hero.h"
+#include "Enemies.h"
+#include "Projectiles.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+using namespace std;
+
+// A copy of everything a save file contains. The manager fills it on the main thread, which is only copying the
+// columns, and the SaveWriter turns it into the file on its own thread while the game goes on.
+struct GameSnapshot {
+    HeroState hero = {};
+    bool isInfinite = false;
+    unsigned int typeCount = 0;
+    EnemyArchetype enemies;
+    ProjectileArchetype projectiles;
+    uint64_t seed = 0;
+    uint32_t randomState[4] = {};
+    uint32_t checkpoint = 0; // the number of the autosave checkpoint, 0 for a normal save
+};
+
+// The binary save file. It is laid out like the columns in memory: a header, a table of sections and then every
+// column as one section of plain numbers, each starting at a multiple of 64 bytes. Loading maps the file and copies
+// every section straight into its column, nothing is parsed. The text save had a line for each of the 30000
+// projectile slots even when they were empty, here only the live projectiles are stored.
+// The numbers are stored the way x86 and x64 keep them in memory (little endian).
+namespace SnapshotFormat {
+    const char magic[4] = { 'S', 'V', 'S', 'N' };
+    const uint32_t version = 2; // 2 also checks the header
+    const uint32_t alignment = 64;
+
+    enum SectionId : uint32_t {
+        SectionHero = 0,
+        SectionEnemyX,
+        SectionEnemyY,
+        SectionEnemyHealth,
+        SectionEnemyAttackTimer,
+        SectionEnemyType,
+        SectionEnemyId,
+        SectionProjectileX,
+        SectionProjectileY,
+        SectionProjectileDx,
+        SectionProjectileDy,
+        SectionProjectileDamage,
+        SectionProjectileFromHero,
+        SectionProjectileSerial,
+        SectionCount
+    };
+
+    // the size of one element of every section, a file with other sizes is from another version
+    inline uint32_t elementSize(uint32_t id) {
+        static const uint32_t sizes[SectionCount] = {
+            sizeof(HeroState), 4, 4, 4, 4, 1, 4, // hero and enemies
+            4, 4, 4, 4, 4, 1, 4 // projectiles
+        };
+        return sizes[id];
+    }
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t sectionCount;
+        uint32_t checkpoint;
+        uint64_t seed;
+        uint32_t randomState[4];
+        uint32_t isInfinite;
+        uint32_t typeCount;
+        uint64_t fileSize;
+        uint64_t checksum; // of the whole file, with this field as 0
+    };
+
+    struct Section {
+        uint32_t id;
+        uint32_t elementSize;
+        uint32_t count;
+        uint32_t reserved;
+        uint64_t offset; // from the start of the file
+    };
+
+    static_assert(sizeof(Header) == 64, "the header is written as it is");
+    static_assert(sizeof(Section) == 24, "the sections are written as they are");
+    static_assert(sizeof(int) == 4 && sizeof(float) == 4 && sizeof(unsigned int) == 4, "the columns are copied byte for byte");
+
+    // fletcher-64 over 32 bit words. the sums are only reduced every 1024 words so it runs about as fast as the copying.
+    // a and b carry on from the bytes before, only the last bytes given may be fewer than a whole word
+    inline void addChecksum(const unsigned char* data, size_t size, uint64_t& a, uint64_t& b) {
+        const uint64_t mod = 0xFFFFFFFFull;
+        size_t words = size / 4;
+        size_t i = 0;
+        while (i < words) {
+            size_t end = min(words, i + 1024);
+            for (; i < end; i++) {
+                uint32_t w;
+                memcpy(&w, data + i * 4, 4);
+                a += w;
+                b += a;
+            }
+            a %= mod;
+            b %= mod;
+        }
+        if (size % 4 != 0) {
+            uint32_t w = 0;
+            memcpy(&w, data + words * 4, size % 4); // the last bytes are padded with zeros
+            a = (a + w) % mod;
+            b = (b + a) % mod;
+        }
+    }
+
+    // the checksum of a whole file, the header is counted with its checksum field as 0 so a broken header is found too
+    inline uint64_t checksum(const unsigned char* file, size_t size) {
+        Header header;
+        memcpy(&header, file, sizeof(Header));
+        header.checksum = 0;
+        uint64_t a = 0, b = 0;
+        addChecksum((const unsigned char*)&header, sizeof(Header), a, b);
+        addChecksum(file + sizeof(Header), size - sizeof(Header), a, b);
+        return (b << 32) | a;
+    }
+}
+
+// builds the whole file in memory, the SaveWriter writes it out
+inline void encodeSnapshot(const GameSnapshot& s, string& out) {
+    using namespace SnapshotFormat;
+    const EnemyArchetype& e = s.enemies;
+    const ProjectileArchetype& p = s.projectiles;
+    struct Column {
+        uint32_t count;
+        const void* data;
+    };
+    Column columns[SectionCount] = {
+        { 1, &s.hero },
+        { e.size(), e.x.data() }, { e.size(), e.y.data() }, { e.size(), e.health.data() },
+        { e.size(), e.attackTimer.data() }, { e.size(), e.type.data() }, { e.size(), e.id.data() },
+        { p.size(), p.x.data() }, { p.size(), p.y.data() }, { p.size(), p.dx.data() }, { p.size(), p.dy.data() },
+        { p.size(), p.damage.data() }, { p.size(), p.fromHero.data() }, { p.size(), p.serial.data() }
+    };
+
+    // where every section goes
+    Section table[SectionCount];
+    uint64_t offset = sizeof(Header) + sizeof(table);
+    for (uint32_t id = 0; id < SectionCount; id++) {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        table[id].id = id;
+        table[id].elementSize = elementSize(id);
+        table[id].count = columns[id].count;
+        table[id].reserved = 0;
+        table[id].offset = offset;
+        offset += (uint64_t)table[id].elementSize * table[id].count;
+    }
+
+    out.assign((size_t)offset, '\0');
+    unsigned char* file = (unsigned char*)&out[0];
+    memcpy(file + sizeof(Header), table, sizeof(table));
+    for (uint32_t id = 0; id < SectionCount; id++) {
+        if (table[id].count > 0) {
+            memcpy(file + table[id].offset, columns[id].data, (size_t)table[id].elementSize * table[id].count);
+        }
+    }
+
+    Header header = {};
+    memcpy(header.magic, magic, 4);
+    header.version = version;
+    header.sectionCount = SectionCount;
+    header.checkpoint = s.checkpoint;
+    header.seed = s.seed;
+    memcpy(header.randomState, s.randomState, sizeof(header.randomState));
+    header.isInfinite = s.isInfinite ? 1 : 0;
+    header.typeCount = s.typeCount;
+    header.fileSize = offset;
+    memcpy(file, &header, sizeof(Header));
+    header.checksum = checksum(file, (size_t)offset);
+    memcpy(file, &header, sizeof(Header));
+}
+
+// points into a loaded file, valid as long as the file stays mapped
+struct SnapshotView {
+    SnapshotFormat::Header header;
+    const void* sections[SnapshotFormat::SectionCount];
+    uint32_t counts[SnapshotFormat::SectionCount];
+
+    template <typename T>
+    const T* column(uint32_t id) const {
+        return (const T*)sections[id];
+    }
+};
+
+// checks the file and finds the sections, error says what was wrong
+inline bool decodeSnapshot(const unsigned char* data, size_t size, SnapshotView& view, string& error) {
+    using namespace SnapshotFormat;
+    if (size < sizeof(Header)) {
+        error = "the file is too short";
+        return false;
+    }
+    memcpy(&view.header, data, sizeof(Header));
+    const Header& h = view.header;
+    if (memcmp(h.magic, magic, 4) != 0 || h.version != version) {
+        error = "not a save file of this version";
+        return false;
+    }
+    if (h.fileSize != size || h.sectionCount < SectionCount || size < sizeof(Header) + (uint64_t)h.sectionCount * sizeof(Section)) {
+        error = "the file is cut off";
+        return false;
+    }
+    if (checksum(data, size) != h.checksum) {
+        error = "the checksum doesn't match";
+        return false;
+    }
+    for (uint32_t id = 0; id < SectionCount; id++) {
+        view.sections[id] = nullptr;
+        view.counts[id] = 0;
+    }
+    for (uint32_t i = 0; i < h.sectionCount; i++) {
+        Section section;
+        memcpy(&section, data + sizeof(Header) + i * sizeof(Section), sizeof(Section));
+        if (section.id >= SectionCount) {
+            continue; // a section of a newer version that we don't know
+        }
+        if (section.elementSize != elementSize(section.id) || section.offset % alignment != 0 ||
+            section.offset + (uint64_t)section.elementSize * section.count > size) {
+            error = "a section is broken";
+            return false;
+        }
+        view.sections[section.id] = data + section.offset;
+        view.counts[section.id] = section.count;
+    }
+    // every column of the enemies and of the projectiles must have the same length
+    for (uint32_t id = SectionEnemyX; id <= SectionEnemyId; id++) {
+        if (view.counts[id] != view.counts[SectionEnemyX] || (view.counts[id] > 0 && !view.sections[id])) {
+            error = "the enemy sections don't match";
+            return false;
+        }
+    }
+    for (uint32_t id = SectionProjectileX; id <= SectionProjectileSerial; id++) {
+        if (view.counts[id] != view.counts[SectionProjectileX]) {
+            error = "the projectile sections don't match";
+            return false;
+        }
+    }
+    if (view.counts[SectionHero] != 1) {
+        error = "the hero is missing";
+        return false;
+    }
+    const unsigned char* types = view.column<unsigned char>(SectionEnemyType);
+    for (uint32_t i = 0; i < view.counts[SectionEnemyType]; i++) {
+        if (types[i] >= h.typeCount) {
+            error = "an enemy has a type that doesn't exist";
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,93 @@
+#include "SaveWriter.h"
+#include <fstream>
+#include <cstdio>
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+void SaveWriter::workerLoop() {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> guard(lock);
+            workAvailable.wait(guard, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                break; // stopping, but only once everything queued is written
+            }
+            task = move(tasks.front());
+            tasks.pop_front();
+            busy = true;
+        }
+
+        task(); // outside the lock so the game can queue the next save meanwhile
+
+        {
+            lock_guard<mutex> guard(lock);
+            busy = false;
+        }
+        allDone.notify_all();
+    }
+}
+
+SaveWriter::~SaveWriter() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void SaveWriter::run(function<void()> task) {
+    {
+        lock_guard<mutex> guard(lock);
+        if (!worker.joinable()) {
+            worker = thread(&SaveWriter::workerLoop, this);
+        }
+        tasks.push_back(move(task));
+    }
+    workAvailable.notify_one();
+}
+
+void SaveWriter::wait() {
+    unique_lock<mutex> guard(lock);
+    allDone.wait(guard, [this] { return tasks.empty() && !busy; });
+}
+
+bool SaveWriter::writeFileNow(const string& filename, const string& data) {
+    string temp = filename + ".tmp";
+    {
+        ofstream file(temp, ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            cout << "Error: cannot write " << temp << endl;
+            return false;
+        }
+        file.write(data.data(), data.size());
+        if (!file) {
+            cout << "Error: writing " << temp << " failed" << endl;
+            return false;
+        }
+    }
+    // the old file is replaced in one step, so a crash leaves either the old or the new save but never none
+#ifdef _WIN32
+    if (!MoveFileExA(temp.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+#else
+    if (std::rename(temp.c_str(), filename.c_str()) != 0) {
+#endif
+        cout << "Error: cannot rename " << temp << " to " << filename << endl;
+        return false;
+    }
+    return true;
+}
+
+bool SaveWriter::appendFileNow(const string& filename, const string& data) {
+    ofstream file(filename, ios::binary | ios::app);
+    if (!file.is_open()) {
+        cout << "Error: cannot write " << filename << endl;
+        return false;
+    }
+    file.write(data.data(), data.size());
+    return (bool)file;
+}
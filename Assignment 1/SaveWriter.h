@@ -0,0 +1,45 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+using namespace std;
+
+// The SaveWriter does the slow part of saving on its own thread: turning the saved state into text and writing the
+// files. The game only copies what has to be saved and hands it over, so saving doesn't stop a frame.
+// The tasks run one after the other in the order they were queued, so a journal entry can never be written before
+// the snapshot it belongs to. The thread is only started when the first task comes.
+class SaveWriter {
+    deque<function<void()>> tasks;
+    thread worker;
+    mutex lock;
+    condition_variable workAvailable; // wakes up the worker when a task is queued
+    condition_variable allDone; // wakes up wait() when the queue is empty
+    bool busy = false; // the worker is running a task right now
+    bool stopping = false;
+
+    void workerLoop();
+
+public:
+    SaveWriter() {}
+    ~SaveWriter();
+
+    SaveWriter(const SaveWriter&) = delete;
+    SaveWriter& operator=(const SaveWriter&) = delete;
+
+    // queues any work, it must only use data it owns because the game keeps changing its own state
+    void run(function<void()> task);
+
+    // blocks until everything that was queued is on the disk, loading does this first
+    void wait();
+
+    // writes the whole file: first to filename.tmp and then it is renamed, so a crash while writing leaves the old file.
+    // this and appendFileNow run on the calling thread, the tasks use them
+    static bool writeFileNow(const string& filename, const string& data);
+
+    // adds data to the end of the file
+    static bool appendFileNow(const string& filename, const string& data);
+};
@@ -0,0 +1,315 @@
+#pragma once
+#include "Camera.h"
+#include "Hero.h"
+#include "Manager.h"
+#include "World.h"
+#include "Random.h"
+#include "InputState.h"
+#include "Replay.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <chrono>
+using namespace std;
+
+// one setup of the game to simulate, they are read from Resources/sim.txt
+struct SimConfig {
+    string name = "default";
+    int level = 1;
+    float difficulty = 0.0f; // the multiplier of the enemy dt, 0 means the game's own 1 + 0.2 * (level - 1)
+    float spawnIntervalScale = 1.0f; // multiplies the spawn intervals of every enemy type
+    unsigned int sessions = 16; // how many games with different seeds
+    float duration = 120.0f; // seconds, the length of a level
+    float tickRate = 60.0f; // updates per simulated second
+    bool isInfinite = false;
+
+    float getDifficulty() const {
+        return (difficulty > 0.0f) ? difficulty : 1.0f + (level - 1) * 0.2f;
+    }
+};
+
+// what one simulated game ended with
+struct SimResult {
+    float survivalTime = 0.0f;
+    int score = 0;
+    unsigned int peakEnemies = 0;
+    unsigned int peakProjectiles = 0;
+    bool survived = false; // still alive at the end of the level
+};
+
+// A game without a window: the hero, the manager and a camera, updated in the same order as the game loop in
+// main.cpp but nothing is drawn. The world map is only read so all the sessions share one.
+// A SimSession is reused for many games like the GameSession is reused for the levels, so the enemy and projectile
+// columns are allocated once per thread.
+// The sprites and the images are on the drawing side (WorldRenderer and ActorRenderer), so this and everything it
+// includes builds without GamesEngineeringBase.h, on the linux machines too. One core plays about 11 minutes of game
+// per second at -O2 with the default configs, most of it in the enemy and projectile updates of the manager.
+class SimSession {
+    World& world;
+    Camera camera;
+    Hero hero;
+    Manager manager;
+    Random ai; // the scripted player's own random numbers
+    float difficulty = 1.0f;
+    bool isInfinite = false;
+    float time = 0.0f;
+    SimResult result;
+    // the scripted player wanders in one direction for a while when no enemy is close
+    float wanderTimer = 0.0f;
+    uint32_t wanderKeys = 0;
+
+public:
+    explicit SimSession(World& _world)
+        : world(_world),
+          camera(1024, 768, 1344, 1344),
+          hero(500, 400) {
+        hero.setLogEvents(false); // thousands of games would spend most of their time printing
+        manager.setLogEvents(false);
+    }
+
+    // starts a new game, the same level, settings, seed and attempt always give the same game
+    void reset(int level, float _difficulty, float spawnIntervalScale, bool _isInfinite, uint64_t seed, uint32_t attempt = 0) {
+        RandomService random(seed);
+        difficulty = _difficulty;
+        isInfinite = _isInfinite;
+        hero.reset(500, 400);
+        manager.setSpawnIntervalScale(spawnIntervalScale);
+        manager.reset(level);
+        manager.seedRandom(random, level, attempt);
+        ai = random.stream(StreamAI);
+        camera.update(hero.getX(), hero.getY(), isInfinite);
+        time = 0.0f;
+        result = SimResult();
+        wanderTimer = 0.0f;
+        wanderKeys = 0;
+    }
+
+    // one tick of the game loop, false once the hero is dead
+    bool step(float dt, const InputState& input) {
+        if (hero.isDead()) {
+            return false;
+        }
+        camera.update(hero.getX(), hero.getY(), isInfinite);
+        hero.update(input, dt, world, manager, camera, isInfinite);
+        manager.update(dt * difficulty, camera, hero, isInfinite);
+
+        time += dt;
+        result.survivalTime = time;
+        result.score = hero.getScore();
+        result.peakEnemies = max(result.peakEnemies, manager.getEnemyCount());
+        result.peakProjectiles = max(result.peakProjectiles, manager.getProjectileCount());
+        return !hero.isDead();
+    }
+
+    // the scripted player: it runs away from the closest enemy, uses the area attack when enemies are in its range
+    // and the power up whenever it can. the linear attack of the hero is automatic anyway
+    InputState policy(float dt) {
+        InputState input;
+        float hx = hero.getX();
+        float hy = hero.getY();
+        int closest = manager.getClosestEnemy(hx, hy, 250.0f);
+        if (closest >= 0) {
+            float ex = manager.getEnemyX(closest);
+            float ey = manager.getEnemyY(closest);
+            if (fabsf(ex - hx) > 4.0f) input.setKey(ex < hx ? 'D' : 'A', true);
+            if (fabsf(ey - hy) > 4.0f) input.setKey(ey < hy ? 'S' : 'W', true);
+            if (manager.getClosestEnemy(hx, hy, hero.getAreaAttackRange()) >= 0) {
+                input.setKey(' ', true);
+            }
+            input.setKey('F', true);
+        }
+        else {
+            wanderTimer -= dt;
+            if (wanderTimer <= 0.0f) {
+                wanderKeys = ai.below(9); // 3 x 3 directions, 4 is standing still
+                wanderTimer = 0.5f + ai.uniform();
+            }
+            int wx = (int)(wanderKeys % 3) - 1;
+            int wy = (int)(wanderKeys / 3) - 1;
+            if (wx != 0) input.setKey(wx < 0 ? 'A' : 'D', true);
+            if (wy != 0) input.setKey(wy < 0 ? 'W' : 'S', true);
+        }
+        // in a finite world running into the edge means being cornered, so it turns back towards the middle
+        if (!isInfinite) {
+            const float edge = 96.0f;
+            if (hx < edge) { input.setKey('A', false); input.setKey('D', true); }
+            if (hx > WORLD_WIDTH - edge) { input.setKey('D', false); input.setKey('A', true); }
+            if (hy < edge) { input.setKey('W', false); input.setKey('S', true); }
+            if (hy > WORLD_HEIGHT - edge) { input.setKey('S', false); input.setKey('W', true); }
+        }
+        return input;
+    }
+
+    const SimResult& getResult() const {
+        return result;
+    }
+
+    int getScore() {
+        return hero.getScore();
+    }
+};
+
+// Runs many games as fast as the CPU allows, for balancing the difficulty and the spawn intervals without playing
+// 2 minute levels. Every game is independent so they are spread over all the cores, a thread takes the next game
+// as soon as it finished one.
+class SimRunner {
+public:
+    // the file has blocks that start with "config <name>" like the enemy file, the keys after it belong to that config
+    static bool loadConfigs(const string& filename, vector<SimConfig>& configs) {
+        configs.clear();
+        ifstream infile(filename);
+        if (!infile.is_open()) {
+            cout << "Error: cannot open simulation file: " << filename << endl;
+            return false;
+        }
+        string line;
+        while (getline(infile, line)) {
+            if (!line.empty() && line[line.size() - 1] == '\r') {
+                line.erase(line.size() - 1);
+            }
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            stringstream parts(line);
+            string key;
+            parts >> key;
+            if (key == "config") {
+                configs.push_back(SimConfig());
+                parts >> configs.back().name;
+                continue;
+            }
+            if (configs.empty()) {
+                cout << "Warning: " << key << " before the first config in " << filename << endl;
+                continue;
+            }
+            SimConfig& config = configs.back();
+            if (key == "level") parts >> config.level;
+            else if (key == "difficulty") parts >> config.difficulty;
+            else if (key == "spawnIntervalScale") parts >> config.spawnIntervalScale;
+            else if (key == "sessions") parts >> config.sessions;
+            else if (key == "duration") parts >> config.duration;
+            else if (key == "tickRate") parts >> config.tickRate;
+            else if (key == "infinite") parts >> config.isInfinite;
+            else cout << "Warning: unknown key " << key << " in " << filename << endl;
+        }
+        infile.close();
+        return !configs.empty();
+    }
+
+    // simulates every session of every config and writes one line per config to resultFile
+    static void run(const vector<SimConfig>& configs, uint64_t seed, unsigned int threadCount, const string& resultFile) {
+        struct Job {
+            unsigned int config;
+            uint64_t seed;
+        };
+        vector<Job> jobs;
+        uint64_t seedState = seed;
+        for (unsigned int c = 0; c < configs.size(); c++) {
+            for (unsigned int s = 0; s < configs[c].sessions; s++) {
+                Job job;
+                job.config = c;
+                job.seed = Random::splitMix(seedState); // every game has its own seed, all made from the run's seed
+                jobs.push_back(job);
+            }
+        }
+        if (threadCount == 0) {
+            threadCount = max(1u, thread::hardware_concurrency());
+        }
+        threadCount = min(threadCount, max(1u, (unsigned int)jobs.size()));
+        cout << "Simulating " << jobs.size() << " games on " << threadCount << " threads" << endl;
+
+        World world("Resources/tiles.txt"); // only read by the hero, so one map is enough for every thread
+        vector<SimResult> results(jobs.size()); // every game writes only its own result
+        atomic<unsigned int> nextJob(0);
+        auto start = chrono::high_resolution_clock::now();
+
+        auto worker = [&]() {
+            SimSession session(world);
+            for (unsigned int j = nextJob++; j < jobs.size(); j = nextJob++) {
+                const SimConfig& config = configs[jobs[j].config];
+                session.reset(config.level, config.getDifficulty(), config.spawnIntervalScale, config.isInfinite, jobs[j].seed);
+                float dt = 1.0f / config.tickRate;
+                unsigned int ticks = (unsigned int)(config.duration * config.tickRate + 0.5f);
+                bool alive = true;
+                for (unsigned int t = 0; t < ticks && alive; t++) {
+                    alive = session.step(dt, session.policy(dt));
+                }
+                results[j] = session.getResult();
+                results[j].survived = alive;
+            }
+        };
+        vector<thread> workers;
+        for (unsigned int i = 0; i < threadCount; i++) {
+            workers.emplace_back(worker);
+        }
+        for (unsigned int i = 0; i < workers.size(); i++) {
+            workers[i].join();
+        }
+        float seconds = chrono::duration_cast<chrono::duration<float>>(chrono::high_resolution_clock::now() - start).count();
+
+        // the games are summed up per config
+        ofstream out(resultFile);
+        out << "config,level,difficulty,spawnIntervalScale,sessions,survived,meanSurvivalTime,minSurvivalTime,meanScore,maxScore,peakEnemies,peakProjectiles\n";
+        float simulatedSeconds = 0.0f;
+        for (unsigned int c = 0; c < configs.size(); c++) {
+            const SimConfig& config = configs[c];
+            unsigned int count = 0, survived = 0, peakEnemies = 0, peakProjectiles = 0;
+            float totalTime = 0.0f, minTime = config.duration;
+            double totalScore = 0.0;
+            int maxScore = 0;
+            for (unsigned int j = 0; j < jobs.size(); j++) {
+                if (jobs[j].config != c) {
+                    continue;
+                }
+                const SimResult& r = results[j];
+                count++;
+                survived += r.survived ? 1 : 0;
+                totalTime += r.survivalTime;
+                minTime = min(minTime, r.survivalTime);
+                totalScore += r.score;
+                maxScore = max(maxScore, r.score);
+                peakEnemies = max(peakEnemies, r.peakEnemies);
+                peakProjectiles = max(peakProjectiles, r.peakProjectiles);
+            }
+            simulatedSeconds += totalTime;
+            float meanTime = count ? totalTime / count : 0.0f;
+            double meanScore = count ? totalScore / count : 0.0;
+            out << config.name << "," << config.level << "," << config.getDifficulty() << "," << config.spawnIntervalScale << ","
+                << count << "," << survived << "," << meanTime << "," << minTime << "," << meanScore << "," << maxScore << ","
+                << peakEnemies << "," << peakProjectiles << "\n";
+            cout << config.name << ": survived " << survived << "/" << count << ", mean survival " << meanTime << "s, mean score "
+                << meanScore << ", peak enemies " << peakEnemies << ", peak projectiles " << peakProjectiles << endl;
+        }
+        out.close();
+        cout << "Simulated " << simulatedSeconds / 60.0f << " minutes in " << seconds << " seconds ("
+            << (seconds > 0.0f ? simulatedSeconds / 60.0f / seconds : 0.0f) << " minutes per second), results in " << resultFile << endl;
+    }
+
+    // plays a replay file without a window and as fast as possible, it stops where the level in the game would have
+    // stopped: the end of the file, the recorded escape key, the hero's death or the end of the level
+    static int replayHeadless(InputPlayer& player, float levelDuration) {
+        const ReplayHeader& header = player.getHeader();
+        World world("Resources/tiles.txt");
+        SimSession session(world);
+        session.reset(header.level, 1.0f + (header.level - 1) * 0.2f, 1.0f, header.isInfinite, header.seed, header.attempt);
+        auto start = chrono::high_resolution_clock::now();
+        float levelTimer = 0.0f;
+        float dt;
+        InputState input;
+        while (player.next(dt, input)) {
+            levelTimer += dt;
+            if (input.keyPressed(KeyEscape) || !session.step(dt, input) || levelTimer >= levelDuration) {
+                break;
+            }
+        }
+        float seconds = chrono::duration_cast<chrono::duration<float>>(chrono::high_resolution_clock::now() - start).count();
+        cout << "Replay finished after " << player.getTicks() << " ticks (" << levelTimer << "s of game in " << seconds
+            << "s), score: " << session.getScore() << endl;
+        return session.getScore();
+    }
+};
@@ -0,0 +1,137 @@
+#pragma once
+#include <vector>
+#include <cmath>
+using namespace std;
+
+// The SpatialGrid sorts points into square cells so we can ask "what is inside this rectangle" without looking at
+// every point. The world can be infinite so the cells are hashed into a fixed number of buckets instead of being
+// stored in a 2D array. The grid is built again from scratch every frame: insert() only appends, and build() puts
+// the points in bucket order with a counting sort so every bucket is one contiguous block of memory.
+// The vectors keep their capacity between frames so rebuilding doesn't allocate once the game has warmed up.
+class SpatialGrid {
+    struct Entry {
+        int id; // whatever the owner uses to find the object again, for example an index into its arrays
+        int cellX, cellY;
+        float x, y;
+    };
+
+    float cellSize;
+    unsigned int bucketMask; // bucket count - 1, the bucket count is a power of two
+    vector<Entry> entries; // in insertion order
+    vector<Entry> sorted; // in bucket order after build()
+    vector<unsigned int> bucketStart; // bucket b is sorted[bucketStart[b]] .. sorted[bucketStart[b + 1] - 1]
+    vector<unsigned int> cursor; // reused by build()
+
+    int cellOf(float v) const {
+        return (int)floorf(v / cellSize); // floor so that -0.5 is in cell -1 and not in cell 0
+    }
+
+    unsigned int bucketOf(int cx, int cy) const {
+        // two large primes mix the cell coordinates so neighbouring cells end up in different buckets
+        return ((unsigned int)cx * 73856093u ^ (unsigned int)cy * 19349663u) & bucketMask;
+    }
+
+public:
+    // bucketCount is rounded up to a power of two
+    SpatialGrid(float _cellSize = 64.0f, unsigned int bucketCount = 4096) : cellSize(_cellSize) {
+        unsigned int buckets = 1;
+        while (buckets < bucketCount) {
+            buckets <<= 1;
+        }
+        bucketMask = buckets - 1;
+        bucketStart.assign(buckets + 1, 0);
+        cursor.assign(buckets, 0);
+    }
+
+    float getCellSize() const {
+        return cellSize;
+    }
+
+    unsigned int size() const {
+        return (unsigned int)entries.size();
+    }
+
+    // removes every point, the memory is kept for the next frame
+    void clear() {
+        entries.clear();
+        sorted.clear();
+        for (unsigned int i = 0; i < bucketStart.size(); i++) {
+            bucketStart[i] = 0;
+        }
+    }
+
+    void insert(int id, float x, float y) {
+        Entry e;
+        e.id = id;
+        e.x = x;
+        e.y = y;
+        e.cellX = cellOf(x);
+        e.cellY = cellOf(y);
+        entries.push_back(e);
+    }
+
+    // sorts the inserted points into their buckets, has to be called before any query
+    void build() {
+        unsigned int buckets = bucketMask + 1;
+        for (unsigned int i = 0; i <= buckets; i++) {
+            bucketStart[i] = 0;
+        }
+        // count the points of every bucket
+        for (unsigned int i = 0; i < entries.size(); i++) {
+            bucketStart[bucketOf(entries[i].cellX, entries[i].cellY) + 1]++;
+        }
+        // and turn the counts into start positions
+        for (unsigned int b = 0; b < buckets; b++) {
+            bucketStart[b + 1] += bucketStart[b];
+            cursor[b] = bucketStart[b];
+        }
+        sorted.resize(entries.size());
+        for (unsigned int i = 0; i < entries.size(); i++) {
+            unsigned int b = bucketOf(entries[i].cellX, entries[i].cellY);
+            sorted[cursor[b]++] = entries[i];
+        }
+    }
+
+    // calls visit(id, x, y) for every point with x0 <= x <= x1 and y0 <= y <= y1.
+    // only the cells that overlap the rectangle are looked at, so the cost depends on what is inside it
+    template <typename Visitor>
+    void forEachInRect(float x0, float y0, float x1, float y1, Visitor visit) const {
+        forEachInRectWhile(x0, y0, x1, y1, [&visit](int id, float x, float y) {
+            visit(id, x, y);
+            return true;
+        });
+    }
+
+    // the same but it stops as soon as visit returns false, so a query that only wants a few points doesn't pay for a
+    // crowd of hundreds standing in the same cell
+    template <typename Visitor>
+    void forEachInRectWhile(float x0, float y0, float x1, float y1, Visitor visit) const {
+        if (entries.empty()) {
+            return;
+        }
+        int cx0 = cellOf(x0);
+        int cy0 = cellOf(y0);
+        int cx1 = cellOf(x1);
+        int cy1 = cellOf(y1);
+        for (int cy = cy0; cy <= cy1; cy++) {
+            for (int cx = cx0; cx <= cx1; cx++) {
+                unsigned int b = bucketOf(cx, cy);
+                for (unsigned int i = bucketStart[b]; i < bucketStart[b + 1]; i++) {
+                    const Entry& e = sorted[i];
+                    // other cells can share the bucket, so we check the cell too (otherwise a point could be found twice)
+                    if (e.cellX != cx || e.cellY != cy) {
+                        continue;
+                    }
+                    if (e.x >= x0 && e.x <= x1 && e.y >= y0 && e.y <= y1 && !visit(e.id, e.x, e.y)) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+
+    // appends the ids of every point inside the rectangle to out
+    void queryRect(float x0, float y0, float x1, float y1, vector<int>& out) const {
+        forEachInRect(x0, y0, x1, y1, [&out](int id, float, float) { out.push_back(id); });
+    }
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include "GamesEngineeringBase.h"
+#include "Camera.h"
+#include "AssetLoader.h"
+#include "RenderQueue.h"
+#include <string>
+using namespace std;
+
+// a sprite sheet has its animation frames next to each other, every frame is frameWidth x frameHeight pixels
+struct SpriteSheet {
+    int texture = -1; // the asset handle, the render queue groups sprites by it
+    GamesEngineeringBase::Image* image = nullptr;
+
+    // takes the image from the asset loader, an empty filename leaves the sheet empty
+    void load(const string& filename) {
+        if (filename.empty()) {
+            texture = -1;
+            image = nullptr;
+            return;
+        }
+        texture = assetLoader.request(filename);
+        image = &assetLoader.get(texture);
+    }
+
+    // queues the given frame of the sheet at world position (x, y)
+    void draw(RenderQueue& sprites, Camera& camera, int frame, int frameWidth, int frameHeight, float x, float y) const {
+        if (!image || image->width == 0 || image->height == 0) { // we only draw if the image was successfully loaded
+            return;
+        }
+        int startX = frame * frameWidth; // if it's the third frame then the starting point becomes 2 x 32 = 64
+        if (startX + frameWidth > (int)image->width) {
+            return;
+        }
+        sprites.submit(texture, *image, startX, 0, frameWidth, frameHeight, (int)(x - camera.getX()), (int)(y - camera.getY()));
+    }
+};
@@ -1,53 +1,50 @@
 #pragma once
 #include "GamesEngineeringBase.h"
+#include "AssetLoader.h"
+#include "Blitter.h"
 #include <iostream>
 using namespace std;
 
 // The TileSet class handles loading and drawing of all tile images 
 class TileSet {
-    GamesEngineeringBase::Image tiles[24]; // we keep an array of 24 images representing each tile type
+    GamesEngineeringBase::Image* tiles[24] = {}; // we keep pointers to the 24 tile images which are owned by the asset loader
     const int TILE_SIZE = 32; // every tile is 32x32 pixels
 
 public:
     TileSet() {} // default constructor 
 
-    // load() reads all 24 tile images from the Resources folder
+    // load() gets all 24 tile images from the asset loader, they are decoded only once no matter how many times the world is created
     void load() {
         for (int i = 0; i < 24; i++) {
             string filename = "Resources/" + to_string(i) + ".png"; // as tile filenames are named 0.png, 1.png, ... 23.png
-            tiles[i].load(filename); // load the tile image
-            if (tiles[i].width == 0) // if width is 0, it means loading failed
-                cout << "Warning: could not load " << filename << endl; // print a warning to console
+            tiles[i] = &assetLoader.get(filename); // the loader prints a warning if the file couldn't be decoded
         }
     }
 
-    // drawTile draws a single tile on the screen at a specific position
-    void drawTile(GamesEngineeringBase::Window& canvas, int id, int x, int y) {
+    // drawTile draws a single tile at a specific position of the target, which is the saved world image.
+    // only the part inside the clip rectangle (clipX0, clipY0) - (clipX1, clipY1) is drawn, so a strip of 1 pixel
+    // that scrolled into view only copies 1 pixel of every tile and not the whole tile
+    void drawTile(const Surface& target, int id, int x, int y, int clipX0, int clipY0, int clipX1, int clipY1) {
         if (id < 0 || id >= 24) { // safety check: make sure tile id is valid
             return;
         }
-        GamesEngineeringBase::Image& img = tiles[id]; // get reference to the tile image
+        if (!tiles[id]) { // load() was not called yet
+            return;
+        }
+        GamesEngineeringBase::Image& img = *tiles[id]; // get reference to the tile image
         if (img.width == 0 || img.height == 0) { // if tile image was not loaded correctly skip drawing
             return;
         }
 
-        // loop through each pixel in the 32x32 tile
-        for (int i = 0; i < TILE_SIZE; i++) {
-            for (int j = 0; j < TILE_SIZE; j++) {
-                int drawX = x + j; // calculate the exact pixel position on the canvas
-                int drawY = y + i;
-
-                // check that this pixel is inside the window boundaries
-                if (drawX < 0 || drawX >= (int)canvas.getWidth() || drawY < 0 || drawY >= (int)canvas.getHeight()) {
-                    continue;
-                }
-
-                // draw the pixel 
-                if (img.alphaAtUnchecked(j, i) > 0) {
-                    canvas.draw(drawX, drawY, img.atUnchecked(j, i));
-                }
-            }
+        int x0 = max(x, clipX0);
+        int y0 = max(y, clipY0);
+        int x1 = min(x + TILE_SIZE, clipX1);
+        int y1 = min(y + TILE_SIZE, clipY1);
+        if (x0 >= x1 || y0 >= y1) {
+            return;
         }
+        // copy the part of the 32x32 tile, the blitter clips it against the window boundaries
+        Blitter::drawImage(target, img, x0 - x, y0 - y, x1 - x0, y1 - y0, x0, y0);
     }
 
     // returns how many tiles exist in this set
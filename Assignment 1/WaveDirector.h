@@ -0,0 +1,139 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// the numbers the wave director works with, they are read from Resources/waves.txt
+struct WaveSettings {
+    unsigned int maxEnemies = 1500; // no more enemies than this can be alive at once, over all types
+    float basePopulation = 150.0f; // the spawns slow down as the population gets close to this on level 1
+    float populationPerLevel = 100.0f; // and every level allows this many more
+    unsigned int maxSpawnsPerFrame = 2; // the spawns are spread over the frames instead of coming all at once
+    float frameBudget = 1.0f / 60.0f; // seconds, when frames take longer than this the spawns slow down
+};
+
+// The WaveDirector decides how many enemies of every type spawn in a frame.
+// Every enemy type used to have its own timer and spawned one enemy whenever it ran out, no matter how many enemies
+// were already alive or how slow the game was running, until the type hit its limit and the spawns were silently
+// dropped. Now every type collects spawn credit at the rate its spawn interval gives, scaled down by:
+//  - the population: the closer we are to the level's target population the slower new enemies come
+//  - the frame time: if the average frame takes longer than the budget the spawns slow down and stop at twice the budget
+// A whole credit is one enemy. At most maxSpawnsPerFrame enemies spawn in one frame, handed out between the types in
+// turns, and never more than maxEnemies are alive.
+class WaveDirector {
+    WaveSettings settings;
+    int level = 1;
+    float averageFrameTime = 0.0f; // smoothed so one slow frame doesn't stop the spawns
+    vector<float> credit; // the spawn credit of every type
+    unsigned int nextType = 0; // the type that gets the first spawn of the next frame, so no type is always first
+
+public:
+    // reads the settings, the defaults stay for anything that isn't in the file
+    bool loadSettings(const string& filename) {
+        ifstream infile(filename);
+        if (!infile.is_open()) {
+            cout << "Error: cannot open wave file: " << filename << endl;
+            return false;
+        }
+        string line;
+        while (getline(infile, line)) {
+            if (line.empty() || line[0] == '#' || line[0] == '\r') {
+                continue;
+            }
+            stringstream parts(line);
+            string key;
+            parts >> key;
+            if (key == "maxEnemies") parts >> settings.maxEnemies;
+            else if (key == "basePopulation") parts >> settings.basePopulation;
+            else if (key == "populationPerLevel") parts >> settings.populationPerLevel;
+            else if (key == "maxSpawnsPerFrame") parts >> settings.maxSpawnsPerFrame;
+            else if (key == "frameBudgetMs") {
+                float ms = 0.0f;
+                parts >> ms;
+                if (ms > 0.0f) {
+                    settings.frameBudget = ms / 1000.0f;
+                }
+            }
+            else cout << "Warning: unknown key " << key << " in " << filename << endl;
+        }
+        infile.close();
+        return true;
+    }
+
+    const WaveSettings& getSettings() const {
+        return settings;
+    }
+
+    // starts a level, the credit and the frame times of the last level are thrown away
+    void reset(unsigned int typeCount, int _level) {
+        level = (_level > 0) ? _level : 1;
+        credit.assign(typeCount, 0.0f);
+        nextType = 0;
+        averageFrameTime = 0.0f; // the slow frames of the last level must not slow down this one
+    }
+
+    // the real time a frame took, measured by the main loop
+    void reportFrameTime(float seconds) {
+        if (averageFrameTime == 0.0f) {
+            averageFrameTime = seconds;
+        }
+        averageFrameTime += (seconds - averageFrameTime) * 0.1f;
+    }
+
+    // the number everything is multiplied with, 1 means the types spawn as fast as their intervals say
+    float budgetScale(unsigned int population) const {
+        float target = settings.basePopulation + settings.populationPerLevel * (level - 1);
+        if (target > (float)settings.maxEnemies) {
+            target = (float)settings.maxEnemies;
+        }
+        float populationScale = (target > 0.0f) ? 1.0f - population / target : 0.0f;
+        if (populationScale < 0.0f) {
+            populationScale = 0.0f;
+        }
+        float frameScale = 1.0f;
+        if (averageFrameTime > settings.frameBudget) {
+            frameScale = 2.0f - averageFrameTime / settings.frameBudget; // 1 at the budget, 0 at twice the budget
+            if (frameScale < 0.0f) {
+                frameScale = 0.0f;
+            }
+        }
+        return populationScale * frameScale;
+    }
+
+    // rates has the spawns per second of every type, counts gets how many of every type should spawn in this frame
+    void plan(float dt, const vector<float>& rates, unsigned int population, vector<unsigned int>& counts) {
+        unsigned int typeCount = (unsigned int)credit.size();
+        counts.assign(typeCount, 0);
+        if (typeCount == 0) {
+            return;
+        }
+        float scale = budgetScale(population);
+        for (unsigned int t = 0; t < typeCount; t++) {
+            credit[t] += rates[t] * dt * scale;
+            // a type can't save up more than a frame of spawns, otherwise they would all come at once after a slow part
+            if (credit[t] > (float)settings.maxSpawnsPerFrame) {
+                credit[t] = (float)settings.maxSpawnsPerFrame;
+            }
+        }
+
+        unsigned int room = (population < settings.maxEnemies) ? settings.maxEnemies - population : 0;
+        unsigned int allowed = min(room, settings.maxSpawnsPerFrame);
+        bool gaveOne = true;
+        while (allowed > 0 && gaveOne) {
+            gaveOne = false;
+            for (unsigned int k = 0; k < typeCount && allowed > 0; k++) {
+                unsigned int t = (nextType + k) % typeCount;
+                if (credit[t] >= 1.0f) {
+                    credit[t] -= 1.0f;
+                    counts[t]++;
+                    allowed--;
+                    gaveOne = true;
+                }
+            }
+        }
+        nextType = (nextType + 1) % typeCount;
+    }
+};
@@ -0,0 +1,213 @@
+#pragma once
+#include "GamesEngineeringBase.h"
+#include "World.h"
+#include "TileSet.h"
+#include "Camera.h"
+#include "Blitter.h"
+#include <cstring>
+#include <cstdlib>
+using namespace std;
+
+// Draws the World on the screen with the tile images. It keeps the drawn view between frames, so a camera that moved
+// a few pixels only needs the new strips drawn.
+class WorldRenderer {
+    const World& world;
+    TileSet ts;
+    const int TILE_SIZE = 32;
+    Surface layer; // the last drawn view of the world, kept between frames
+    bool layerValid = false;
+    bool layerInfinite = false;
+    int layerCamX = 0; // the camera position the layer was drawn for
+    int layerCamY = 0;
+
+    // division that rounds down for negative numbers too, so -1 / 32 gives -1 and not 0
+    static int floorDiv(int a, int b) {
+        int q = a / b;
+        if ((a % b != 0) && ((a < 0) != (b < 0))) {
+            q--;
+        }
+        return q;
+    }
+
+    // moves the content of the layer by the camera movement, the part that scrolls out of view is lost and
+    // the strips that come into view have to be drawn by the caller
+    void scrollLayer(int dx, int dy) {
+        int bpp = layer.bytesPerPixel;
+        int rowBytes = (layer.width - abs(dx)) * bpp;
+        int dstOffset = (dx < 0) ? -dx * bpp : 0;
+        int srcOffset = (dx > 0) ? dx * bpp : 0;
+        if (dy > 0) {
+            // the camera moved down so rows move up, we go top to bottom so we never read a row we already overwrote
+            for (int y = 0; y < layer.height - dy; y++) {
+                memmove(layer.row(y) + dstOffset, layer.row(y + dy) + srcOffset, rowBytes);
+            }
+        }
+        else {
+            for (int y = layer.height - 1; y >= -dy; y--) {
+                memmove(layer.row(y) + dstOffset, layer.row(y + dy) + srcOffset, rowBytes);
+            }
+        }
+    }
+
+    // fills a part of the layer with black, used where the view goes past the edge of a finite map
+    void clearRegion(int x0, int y0, int x1, int y1) {
+        for (int y = y0; y < y1; y++) {
+            memset(layer.row(y) + x0 * layer.bytesPerPixel, 0, (x1 - x0) * layer.bytesPerPixel);
+        }
+    }
+
+public:
+    explicit WorldRenderer(const World& _world) : world(_world) {
+        ts.load();
+    }
+
+    ~WorldRenderer() {
+        delete[] layer.pixels;
+    }
+
+    WorldRenderer(const WorldRenderer&) = delete;
+    WorldRenderer& operator=(const WorldRenderer&) = delete;
+
+    // at first I implemented the finite version so i needed to made changes for infinite one
+    // draws the screen rectangle (x0, y0) - (x1, y1) of the world into the target, the tiles that overlap it are cut
+    // to it. camX and camY are the world position of the top left pixel of the target
+    void drawRegion(const Surface& target, int camX, int camY, int x0, int y0, int x1, int y1, bool isInfinite) {
+        // we calculate the infinite tile coordinates that are visible in the region
+        // for negative values we got values like -1.5 and they get converted to -1, dividing with floor gives us the right tile
+        int tileStartX = floorDiv(camX + x0, TILE_SIZE); // the tile under the top left pixel of the region
+        int tileStartY = floorDiv(camY + y0, TILE_SIZE); // same for y
+        int tileEndX = floorDiv(camX + x1 - 1, TILE_SIZE); // the tile under the bottom right pixel
+        int tileEndY = floorDiv(camY + y1 - 1, TILE_SIZE);
+
+        //finite world
+        if (!isInfinite) {
+            for (int y = tileStartY; y <= tileEndY; y++) {
+                for (int x = tileStartX; x <= tileEndX; x++) {
+
+                    // we only draw tiles within the map bounds
+                    if (x < 0 || x >= world.getWidth() || y < 0 || y >= world.getHeight()) {
+                        continue;
+                    }
+
+                    int tileID = world.tileAt(y, x);
+                    if (tileID < 0 || tileID >= ts.getTileCount()) {
+                        continue;
+                    }
+                    // we calculate the screen position
+                    int drawX = x * TILE_SIZE - camX;
+                    int drawY = y * TILE_SIZE - camY;
+
+                    ts.drawTile(target, tileID, drawX, drawY, x0, y0, x1, y1);
+                }
+            }
+        }
+        else {
+            // infinite world
+            int width = world.getWidth();
+            int height = world.getHeight();
+            for (int y = tileStartY; y <= tileEndY; y++) {
+                for (int x = tileStartX; x <= tileEndX; x++) {
+                    // the reason we don't use coord / width is that for negative numbers it becomes a problem
+                    // for -1 / 42 we get -1 and we don't have such index
+                    //here we get -1 after x % width but adding 42 again makes it 41 and after that 41 % 42 gives us 41 back so this is what we exactly want
+                    int mapTileX = (x % width + width) % width;
+                    int mapTileY = (y % height + height) % height;
+
+                    int tileID = world.tileAt(mapTileY, mapTileX);
+                    if (tileID < 0 || tileID >= ts.getTileCount()) {
+                        continue;
+                    }
+                    int drawX = x * TILE_SIZE - camX;
+                    int drawY = y * TILE_SIZE - camY;
+
+                    ts.drawTile(target, tileID, drawX, drawY, x0, y0, x1, y1);
+                }
+            }
+        }
+    }
+
+    // draws the world on the screen. the world image of the last frame is kept in the layer, when the camera moves we
+    // shift it by the camera movement and only draw the tiles of the strips that just came into view, then the
+    // layer is copied to the screen. a hero walking at 100 pixels per second only needs a few new pixel rows per frame
+    void draw(GamesEngineeringBase::Window& canvas, Camera& camera, bool isInfinite) {
+        if (!world.isLoaded()) {
+            canvas.clear();
+            return;
+        }
+        // we have to get camera and screen info
+        int camX = (int)camera.getX(); // the camera is always on whole pixels
+        int camY = (int)camera.getY();
+        int screenWidth = canvas.getWidth();
+        int screenHeight = canvas.getHeight();
+
+        // the layer has the same layout as the screen so it can be copied with one memcpy
+        if (layer.pixels == nullptr || layer.width != screenWidth || layer.height != screenHeight || layer.pitch != canvas.getPitch()) {
+            delete[] layer.pixels;
+            layer.width = screenWidth;
+            layer.height = screenHeight;
+            layer.pitch = canvas.getPitch();
+            layer.bytesPerPixel = canvas.getBytesPerPixel();
+            layer.pixels = new unsigned char[layer.pitch * layer.height];
+            layerValid = false;
+        }
+
+        int dx = camX - layerCamX; // how far the camera moved since the layer was drawn
+        int dy = camY - layerCamY;
+        bool covered = coversView(camera, screenWidth, screenHeight, isInfinite);
+
+        if (!layerValid || isInfinite != layerInfinite || abs(dx) >= screenWidth || abs(dy) >= screenHeight) {
+            // nothing of the old image is visible anymore so we draw the whole view
+            if (!covered) {
+                clearRegion(0, 0, screenWidth, screenHeight);
+            }
+            drawRegion(layer, camX, camY, 0, 0, screenWidth, screenHeight, isInfinite);
+        }
+        else if (dx != 0 || dy != 0) {
+            scrollLayer(dx, dy);
+
+            // the strip of columns that came into view on the left or the right
+            int stripX0 = (dx > 0) ? screenWidth - dx : 0;
+            int stripX1 = (dx > 0) ? screenWidth : -dx;
+            // the strip of rows that came into view at the top or the bottom
+            int stripY0 = (dy > 0) ? screenHeight - dy : 0;
+            int stripY1 = (dy > 0) ? screenHeight : -dy;
+
+            if (dx != 0) {
+                if (!covered) {
+                    clearRegion(stripX0, 0, stripX1, screenHeight);
+                }
+                drawRegion(layer, camX, camY, stripX0, 0, stripX1, screenHeight, isInfinite);
+            }
+            if (dy != 0) {
+                if (!covered) {
+                    clearRegion(0, stripY0, screenWidth, stripY1);
+                }
+                drawRegion(layer, camX, camY, 0, stripY0, screenWidth, stripY1, isInfinite);
+            }
+        }
+        layerValid = true;
+        layerInfinite = isInfinite;
+        layerCamX = camX;
+        layerCamY = camY;
+
+        memcpy(canvas.getRow(0), layer.pixels, layer.pitch * layer.height);
+    }
+
+    // the world image without any sprites, the dirty tracker copies it back under the sprites of the last frame
+    const unsigned char* getLayer() const {
+        return layer.pixels;
+    }
+
+    // true if the tiles cover every pixel of the view, then the screen doesn't have to be cleared before drawing the world
+    bool coversView(Camera& camera, int viewWidth, int viewHeight, bool isInfinite) {
+        if (!world.isLoaded()) {
+            return false;
+        }
+        if (isInfinite) {
+            return true; // the map repeats forever
+        }
+        float camX = camera.getX();
+        float camY = camera.getY();
+        return camX >= 0 && camY >= 0 && camX + viewWidth <= world.getWidth() * TILE_SIZE && camY + viewHeight <= world.getHeight() * TILE_SIZE;
+    }
+};
@@ -5,19 +5,30 @@
 #include "Manager.h"
 #include "Camera.h"
 #include "World.h"
+#include "AssetLoader.h"
+#include "GameSession.h"
+#include "InputState.h"
+#include "Replay.h"
+#include "SimRunner.h"
+#include "SaveCompression.h"
 #include <iostream>
 #include <fstream>
 #include <chrono>
+#include <string>
+#include <cstdlib>
 using namespace std;
 using namespace std::chrono;
 
 float frameTimer = 0.0f;
 int frameCount = 0;
+unsigned int hiddenSprites = 0; // skipped by the front to back drawing since the last log line
 ofstream fpsFile("fps_log.txt"); // log file
+const float LEVEL_DURATION = 120.0f; // each level lasts 2 minutes
 
-void logFPS(float dt) {
+void logFPS(float dt, const Manager& manager, unsigned int hiddenInFrame) {
     frameTimer += dt;
     frameCount++;
+    hiddenSprites += hiddenInFrame;
 
     if (frameTimer >= 1.0f) { // every second
         float avgFPS = frameCount / frameTimer;
@@ -28,52 +39,136 @@ void logFPS(float dt) {
 
         fpsFile << "Time: " << ctime(&currentTime)
             << "Average FPS: " << avgFPS << "\n"
-            << "----------------------" << endl;
+            << "Dropped projectiles: " << manager.getDroppedProjectiles() << "\n" // the projectiles lost so far because the pool was full
+            << "Hidden sprites per frame: " << (float)hiddenSprites / frameCount << "\n" // only with --front-to-back
+            << "Contact hits: ";
+        manager.writeContactHits(fpsFile); // the enemies that touched the hero in this level, by type
+        fpsFile << "\n" << "----------------------" << endl;
 
         frameTimer = 0.0f;
         frameCount = 0;
+        hiddenSprites = 0;
     }
 }
 
 
 int main(int argc, char* argv[])
 {
-    GamesEngineeringBase::Timer tim; // timer for delta time (dt)
-    srand((unsigned int)time(nullptr)); // random seed for enemy spawns
+    // the seed of the whole run, "--seed N" repeats a run that was logged before
+    uint64_t seed = RandomService::seedFromClock();
+    string recordFile; // "--record file" writes the first level that is played to a replay file
+    string replayFile; // "--replay file" plays a replay file back instead of reading the keyboard and the clock
+    bool headless = false; // "--headless" plays the replay without a window
+    bool frontToBack = false; // "--front-to-back" draws the sprites from the front and skips the covered pixels
+    string simFile; // "--sim file" runs the balancing simulation of the configs in the file instead of the game
+    unsigned int simThreads = 0; // "--threads N" for the simulation, 0 uses every core
+    SaveCodec saveCodec = CodecFast; // "--compress none|fast|small" packs the save files, loading works with any of them
+    for (int i = 1; i + 1 < argc; i++) {
+        string option = argv[i];
+        if (option == "--seed") {
+            seed = strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if (option == "--record") {
+            recordFile = argv[i + 1];
+        }
+        else if (option == "--replay") {
+            replayFile = argv[i + 1];
+        }
+        else if (option == "--sim") {
+            simFile = argv[i + 1];
+        }
+        else if (option == "--threads") {
+            simThreads = (unsigned int)atoi(argv[i + 1]);
+        }
+        else if (option == "--compress") {
+            if (!parseSaveCodec(argv[i + 1], saveCodec)) {
+                cout << "Unknown compression " << argv[i + 1] << ", the saves are packed fast" << endl;
+            }
+        }
+    }
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--headless") {
+            headless = true;
+        }
+        else if (string(argv[i]) == "--front-to-back") {
+            frontToBack = true;
+        }
+    }
+
+    InputRecorder recorder;
+    InputPlayer player;
+    bool replaying = false;
     int currentLevel = 1;
 
+    // the images start decoding on the worker threads now, so they are ready by the time the player picks from the menu
+    assetLoader.preloadGameAssets();
+
+    // the window, hero, manager and world live in the session for the whole run. it is created after the first menu
+    // selection so the images decode while the player is still reading the menu
+    GameSession* session = nullptr;
+    bool showMenu = true; // going to the next level skips the menu
+    bool infiniteWorld = false;
+    bool loadSaved = false;
+    bool loadAutosaved = false;
+
+    // a replay starts the level it was recorded in with the same seed, there is no menu
+    if (!replayFile.empty()) {
+        if (!player.open(replayFile)) {
+            return 1;
+        }
+        replaying = true;
+        seed = player.getHeader().seed;
+        currentLevel = player.getHeader().level;
+        infiniteWorld = player.getHeader().isInfinite;
+        showMenu = false;
+        cout << "Replaying " << replayFile << endl;
+    }
+    cout << "Seed: " << seed << endl;
+    fpsFile << "Seed: " << seed << endl;
+
+    // the modes without a window
+    if (replaying && headless) {
+        SimRunner::replayHeadless(player, LEVEL_DURATION);
+        fpsFile.close();
+        return 0;
+    }
+    if (!simFile.empty()) {
+        vector<SimConfig> configs;
+        if (!SimRunner::loadConfigs(simFile, configs)) {
+            return 1;
+        }
+        SimRunner::run(configs, seed, simThreads, "sim_results.csv");
+        fpsFile.close();
+        return 0;
+    }
+
     // main loop that restarts after each level ends
     while (true)
     {
-        GamesEngineeringBase::Window canvas; // create the game window
-        canvas.create(1024, 768, "Survivor Game");
-
-        Camera camera(1024, 768, 1344, 1344); // game camera
-        Hero hero(500, 400, "Resources/Hero - Idle.png", "Resources/Hero - Walk.png"); // create hero
-        Manager manager; // enemy + projectile manager
-        World world("Resources/tiles.txt"); // world (map)
-        
-
         unsigned int fpsFrameCount = 0;
         float fpsTimeAccumulator = 0.0f;
         float fpsUpdateInterval = 1.0f;
         float currentFps = 0.0f;
 
-        bool isInfinite = false;
         int selection;
-        const float LEVEL_DURATION = 120.0f; // each level lasts 2 minutes
         float levelTimer = 0.0f;
 
-        bool saveFileExists = false;
-        {
-            ifstream testFile("savegame.txt");
-            if (testFile) {
-                saveFileExists = true; // detect if a save file exists
+        // Menu 
+        while (showMenu) {
+            bool saveFileExists = false;
+            {
+                ifstream testFile("savegame.sav");
+                ifstream oldFile("savegame.txt"); // a text save from before the binary one
+                if (testFile || oldFile) {
+                    saveFileExists = true; // detect if a save file exists
+                }
+            }
+            bool autosaveExists = false;
+            {
+                ifstream testFile("autosave.sav");
+                autosaveExists = (bool)testFile;
             }
-        }
 
-        // Menu 
-        while (true) {
             cout << "\n==============================" << endl;
             cout << "     SURVIVOR GAME MENU       " << endl;
             cout << "==============================" << endl;
@@ -81,27 +176,36 @@ int main(int argc, char* argv[])
             cout << "Select 1: Infinite world" << endl;
             if (saveFileExists) cout << "Select 2: Load saved game" << endl;
             cout << "Select 3: Exit game" << endl;
+            if (autosaveExists) cout << "Select 4: Continue from autosave" << endl;
             cout << "Your selection: ";
             cin >> selection;
 
             if (selection == 0) {
-                isInfinite = false;
+                infiniteWorld = false;
+                loadSaved = false;
                 cout << "Starting finite world..." << endl;
                 break;
             }
             else if (selection == 1) {
-                isInfinite = true;
+                infiniteWorld = true;
+                loadSaved = false;
                 cout << "Starting infinite world..." << endl;
                 break;
             }
             else if (selection == 2 && saveFileExists) {
                 cout << "Loading saved game..." << endl;
-                manager.loadGame(hero, isInfinite);
-                levelTimer = 0.0f;
+                loadSaved = true;
+                break;
+            }
+            else if (selection == 4 && autosaveExists) {
+                cout << "Loading autosave..." << endl;
+                loadAutosaved = true;
                 break;
             }
             else if (selection == 3) {
                 cout << "Goodbye!" << endl;
+                delete session;
+                fpsFile.close();
                 return 0;
             }
             else {
@@ -109,28 +213,87 @@ int main(int argc, char* argv[])
             }
         }
 
+        if (!session) {
+            session = new GameSession(seed); // the only time the window and the game objects are created
+            session->manager.setSaveCodec(saveCodec);
+            session->sprites.setFrontToBack(frontToBack);
+            if (replaying) {
+                session->nextAttempt = player.getHeader().attempt; // the replayed level spawns like the recorded one
+            }
+        }
+        bool levelStartedFresh = !loadSaved && !loadAutosaved;
+        if (loadSaved) {
+            session->loadSaved();
+            loadSaved = false; // the next level after a loaded game starts normally
+        }
+        else if (loadAutosaved) {
+            session->loadAutosaved();
+            loadAutosaved = false;
+        }
+        else {
+            session->reset(infiniteWorld, currentLevel); // a new level reuses everything, nothing is allocated here
+        }
+
+        GamesEngineeringBase::Window& canvas = session->canvas;
+        Camera& camera = session->camera;
+        Hero& hero = session->hero;
+        Manager& manager = session->manager;
+        World& world = session->world;
+        WorldRenderer& worldRenderer = session->worldRenderer;
+        ActorRenderer& actors = session->actorRenderer;
+        DirtyTracker& dirty = session->dirty;
+        RenderQueue& sprites = session->sprites;
+        bool& isInfinite = session->isInfinite;
+        infiniteWorld = isInfinite; // so the next level keeps the world mode of a loaded game
+
+        // only a level that starts from the beginning can be replayed, a loaded game starts from the save file
+        if (!recordFile.empty() && !replaying && !recorder.isOpen() && levelStartedFresh) {
+            ReplayHeader header;
+            header.seed = session->random.getSeed();
+            header.level = currentLevel;
+            header.isInfinite = isInfinite;
+            header.attempt = session->attempt;
+            if (recorder.open(recordFile, header)) {
+                cout << "Recording to " << recordFile << endl;
+            }
+            recordFile.clear(); // one level is recorded
+        }
+
         float difficultyMultiplier = 1.0f + (currentLevel - 1) * 0.2f; // +20% each level
         cout << "Level " << currentLevel << " started! Difficulty x" << difficultyMultiplier << endl;
 
         levelTimer = 0.0f;
+        showMenu = true; // unless the level is completed with N we go back to the menu
 
         // Game loop (one level = 2 minutes) 
         while (true)
         {
             auto start = high_resolution_clock::now();
-            float dt = tim.dt();
-            levelTimer += dt;
-
             canvas.checkInput();
-            canvas.clear();
 
-            // save
-            if (canvas.keyPressed('K')) {
+            // the time and the keys of this tick come from the window or from the replay, nothing below reads them directly
+            float dt;
+            InputState input;
+            if (replaying) {
+                if (!player.next(dt, input)) {
+                    cout << "\nReplay finished after " << player.getTicks() << " ticks, score: " << hero.getScore() << endl;
+                    break;
+                }
+            }
+            else {
+                dt = session->timer.dt();
+                input = session->readInput();
+                recorder.record(dt, input);
+            }
+            levelTimer += dt;
+
+            // save, a replay doesn't overwrite the save file
+            if (input.keyPressed('K') && !replaying) {
                 manager.saveGame(hero, isInfinite);
                 cout << "Game saved!" << endl;
             }
 
-            if (canvas.keyPressed(VK_ESCAPE)) {
+            if (input.keyPressed(KeyEscape) || canvas.keyPressed(VK_ESCAPE)) { // the real escape key also stops a replay
                 cout << "Game exited early." << endl;
                 break;
             }
@@ -138,7 +301,9 @@ int main(int argc, char* argv[])
             if (hero.isDead()) {
                 cout << "\nGAME OVER!\n";
                 cout << "Final Score: " << hero.getScore() << endl;
-                system("pause");
+                if (!replaying) {
+                    system("pause");
+                }
                 currentLevel = 1;
                 break;
             }
@@ -156,19 +321,32 @@ int main(int argc, char* argv[])
 
             // update world, hero, enemies
             camera.update(hero.getX(), hero.getY(), isInfinite);
-            hero.update(canvas, dt, world, manager, camera, isInfinite);
-            manager.update(canvas, dt * difficultyMultiplier, camera, hero, isInfinite);
+            hero.update(input, dt, world, manager, camera, isInfinite);
+            manager.update(dt * difficultyMultiplier, camera, hero, isInfinite);
+            if (!replaying) {
+                manager.autosaveStep(dt, hero, isInfinite); // nothing most frames, the files are written on the save thread
+            }
 
-            // draw everything
-            world.draw(canvas, camera, isInfinite);
-            hero.draw(canvas, camera);
-            manager.draw(canvas, camera);
+            // draw everything. the world is only drawn again when the camera moved (and then only the newly visible
+            // strips are drawn), otherwise the dirty tracker restores the world under the sprites of the last frame
+            if (dirty.beginFrame((int)camera.getX(), (int)camera.getY())) {
+                worldRenderer.draw(canvas, camera, isInfinite);
+                dirty.backgroundDrawn();
+            }
+            else {
+                dirty.restoreBackground(canvas, worldRenderer.getLayer());
+            }
+            // the hero and the enemies are sorted by y so whoever stands lower on the screen is drawn in front
+            sprites.begin();
+            actors.draw(sprites, canvas, camera, hero, manager);
+            sprites.execute(canvas);
+            actors.drawProjectiles(canvas, camera, manager);
 
             // show AOE range if triggered
             if (hero.getAOE()) {
                 float heroCenterX = hero.getX() + 16.0f;
                 float heroCenterY = hero.getY() + 22.0f;
-                manager.drawAOE(canvas, camera, heroCenterX, heroCenterY, hero.getAreaAttackRange());
+                actors.drawAOE(canvas, camera, heroCenterX, heroCenterY, hero.getAreaAttackRange());
             }
 
             // Level timer check
@@ -181,6 +359,9 @@ int main(int argc, char* argv[])
 
                 // Increase level
                 currentLevel++;
+                if (replaying) {
+                    break; // a replay is one level
+                }
 
                 cout << "Press N to continue to next level or M to return to menu.\n";
                 char nextChoice;
@@ -188,6 +369,7 @@ int main(int argc, char* argv[])
 
                 if (nextChoice == 'N' || nextChoice == 'n') {
                     cout << "Loading next level...\n";
+                    showMenu = false; // the session is reset straight into the next level
                     break; // restart with higher level
                 }
                 else {
@@ -197,13 +379,24 @@ int main(int argc, char* argv[])
                 }
             }
 
-            canvas.present();
+            dirty.present(canvas); // uploads only the rows that changed
             auto end = high_resolution_clock::now();
             float frameDuration = duration_cast<duration<float>>(end - start).count();
-            logFPS(frameDuration);
+            logFPS(frameDuration, manager, sprites.getHiddenCount());
+            if (!recorder.isOpen() && !replaying) {
+                // the real frame time isn't in the replay, throttling on it would make the replay spawn differently
+                manager.reportFrameTime(frameDuration);
+            }
+        }
+        recorder.close(); // the recording ends with its level
+        if (replaying) {
+            break;
+        }
+        if (showMenu) {
+            cout << "\nReturning to main menu...\n\n";
         }
-        cout << "\nReturning to main menu...\n\n";
     }
+    delete session;
     fpsFile.close();
     return 0;
 }